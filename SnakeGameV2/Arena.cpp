@@ -0,0 +1,303 @@
+#include "Arena.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+// Tries at a random cell before giving up on placing food or a snake
+const int PLACEMENT_TRIES = 64;
+
+// Food items a bot looks at when picking a new target
+const int BOT_TARGET_SAMPLES = 8;
+
+// Body buffer a snake spawns with; ArenaTick() doubles it as the snake grows
+const size_t SPAWN_BODY_CAPACITY = 16;
+
+static const int DX[5] = { 0, -1, 1, 0, 0 };
+static const int DY[5] = { 0, 0, 0, -1, 1 };
+
+static bool IsInside(const Arena& arena, int x, int y) {
+    return x > 0 && y > 0 && x < arena.width - 1 && y < arena.height - 1;
+}
+
+static bool IsOpposite(Direction a, Direction b) {
+    return (a == LEFT && b == RIGHT) || (a == RIGHT && b == LEFT) ||
+        (a == UP && b == DOWN) || (a == DOWN && b == UP);
+}
+
+static void LogChange(Arena* arena, int cell, int value) {
+    if (arena->logChanges) arena->changes.push_back(ArenaChange{ cell, value });
+}
+
+static void AddFood(Arena* arena, int cell) {
+    arena->foodSlot[cell] = static_cast<int>(arena->foodCells.size());
+    arena->foodCells.push_back(cell);
+}
+
+static void RemoveFood(Arena* arena, int cell) {
+    int slot = arena->foodSlot[cell];
+    int last = arena->foodCells.back();
+    arena->foodCells[slot] = last;
+    arena->foodSlot[last] = slot;
+    arena->foodCells.pop_back();
+    arena->foodSlot[cell] = -1;
+}
+
+// Top the board up to foodTarget items on random empty cells
+static void RefillFood(Arena* arena) {
+    int tries = 0;
+    while (static_cast<int>(arena->foodCells.size()) < arena->foodTarget && tries < PLACEMENT_TRIES) {
+        int x = 1 + static_cast<int>(arena->rng.Below(arena->width - 2));
+        int y = 1 + static_cast<int>(arena->rng.Below(arena->height - 2));
+        int cell = y * arena->width + x;
+        if (arena->owner[cell] == NO_SNAKE && arena->foodSlot[cell] < 0) {
+            AddFood(arena, cell);
+            LogChange(arena, cell, ARENA_FOOD);
+        }
+        else {
+            tries++;
+        }
+    }
+}
+
+// Clear a dead snake off the board
+static void KillSnake(Arena* arena, int index) {
+    ArenaSnake* snake = &arena->snakes[index];
+    for (size_t i = 0; i < snake->body.size(); i++) {
+        int cell = snake->body[i].y * arena->width + snake->body[i].x;
+        if (arena->owner[cell] == index) {
+            arena->owner[cell] = NO_SNAKE;
+            LogChange(arena, cell, NO_SNAKE);
+        }
+    }
+    snake->body.Reset(0);
+    snake->alive = false;
+    arena->alive--;
+}
+
+void SetupArena(Arena* arena, const ArenaConfig& config) {
+    arena->width = max(MIN_BOARD_SIZE, min(config.width, MAX_BOARD_SIZE));
+    arena->height = max(MIN_BOARD_SIZE, min(config.height, MAX_BOARD_SIZE));
+    arena->tick = 0;
+    arena->foodTarget = max(0, config.food);
+    arena->alive = 0;
+    arena->rng.Seed(config.seed);
+    arena->logChanges = false;
+    arena->changes.clear();
+
+    size_t cells = static_cast<size_t>(arena->width) * arena->height;
+    arena->owner.assign(cells, NO_SNAKE);
+    arena->foodSlot.assign(cells, -1);
+    arena->foodCells.clear();
+    arena->claimTick.assign(cells, 0);
+    arena->claimBy.assign(cells, NO_SNAKE);
+    arena->snakes.clear();
+    arena->heads.clear();
+    arena->dying.clear();
+
+    for (int i = 0; i < config.snakes; i++) SpawnSnake(arena, i);
+    RefillFood(arena);
+}
+
+bool SpawnSnake(Arena* arena, int index) {
+    while (index >= static_cast<int>(arena->snakes.size())) {
+        ArenaSnake empty;
+        empty.dir = STOP;
+        empty.nextDir = STOP;
+        empty.growth = 0;
+        empty.score = 0;
+        empty.alive = false;
+        empty.target = -1;
+        arena->snakes.push_back(empty);
+        arena->heads.push_back(-1);
+        arena->dying.push_back(0);
+    }
+    ArenaSnake* snake = &arena->snakes[index];
+    if (snake->alive) KillSnake(arena, index);
+
+    for (int attempt = 0; attempt < PLACEMENT_TRIES; attempt++) {
+        Direction dir = static_cast<Direction>(LEFT + arena->rng.Below(4));
+        int x = 1 + static_cast<int>(arena->rng.Below(arena->width - 2));
+        int y = 1 + static_cast<int>(arena->rng.Below(arena->height - 2));
+
+        // The body trails behind the head and three cells ahead must be open
+        bool open = true;
+        for (int i = -3; i <= 2 && open; i++) {
+            int cx = x - DX[dir] * i;
+            int cy = y - DY[dir] * i;
+            int cell = cy * arena->width + cx;
+            open = IsInside(*arena, cx, cy) && arena->owner[cell] == NO_SNAKE && arena->foodSlot[cell] < 0;
+        }
+        if (!open) continue;
+
+        snake->body.Reset(SPAWN_BODY_CAPACITY);
+        for (int i = 0; i < 3; i++) {
+            SnakeSegment segment = { x - DX[dir] * i, y - DY[dir] * i };
+            snake->body.PushBack(segment);
+            arena->owner[segment.y * arena->width + segment.x] = index;
+            LogChange(arena, segment.y * arena->width + segment.x, index);
+        }
+        snake->dir = dir;
+        snake->nextDir = dir;
+        snake->growth = 0;
+        snake->score = 0;
+        snake->alive = true;
+        snake->target = -1;
+        arena->alive++;
+        return true;
+    }
+    snake->alive = false;
+    return false;
+}
+
+void RemoveSnake(Arena* arena, int index) {
+    if (arena->snakes[index].alive) KillSnake(arena, index);
+}
+
+void SteerSnake(Arena* arena, int index, Direction dir) {
+    ArenaSnake* snake = &arena->snakes[index];
+    if (dir != STOP && !IsOpposite(dir, snake->dir)) snake->nextDir = dir;
+}
+
+void ArenaTick(Arena* arena) {
+    arena->tick++;
+    int count = static_cast<int>(arena->snakes.size());
+
+    // A snake still growing keeps its tail this tick and gets one segment longer.
+    // Full bodies are doubled here, before the moves, so each buffer follows its
+    // snake's length and the move loops below never allocate.
+    for (int i = 0; i < count; i++) {
+        ArenaSnake* snake = &arena->snakes[i];
+        if (snake->alive && snake->growth > 0 && snake->body.size() == snake->body.capacity()) {
+            snake->body.Grow(snake->body.capacity() * 2);
+        }
+    }
+
+    // Pick each head's next cell and move the tails out first, so following a
+    // tail is safe just like it is for a single snake
+    for (int i = 0; i < count; i++) {
+        ArenaSnake* snake = &arena->snakes[i];
+        if (!snake->alive) continue;
+        snake->dir = snake->nextDir;
+        int x = snake->body[0].x + DX[snake->dir];
+        int y = snake->body[0].y + DY[snake->dir];
+        arena->heads[i] = IsInside(*arena, x, y) ? y * arena->width + x : -1;
+        arena->dying[i] = (arena->heads[i] < 0);
+
+        if (snake->growth > 0) {
+            snake->growth--;
+        }
+        else {
+            const SnakeSegment& tail = snake->body.back();
+            arena->owner[tail.y * arena->width + tail.x] = NO_SNAKE;
+            LogChange(arena, tail.y * arena->width + tail.x, NO_SNAKE);
+            snake->body.PopBack();
+        }
+    }
+
+    // Heads entering the same cell all die; the first one in is marked when the second arrives
+    for (int i = 0; i < count; i++) {
+        int cell = arena->heads[i];
+        if (!arena->snakes[i].alive || cell < 0) continue;
+        if (arena->claimTick[cell] == arena->tick) {
+            arena->dying[i] = 1;
+            arena->dying[arena->claimBy[cell]] = 1;
+        }
+        else {
+            arena->claimTick[cell] = arena->tick;
+            arena->claimBy[cell] = i;
+        }
+    }
+
+    // Any body still on the cell, the snake's own included, kills the head
+    for (int i = 0; i < count; i++) {
+        if (arena->snakes[i].alive && !arena->dying[i] && arena->owner[arena->heads[i]] != NO_SNAKE) {
+            arena->dying[i] = 1;
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        ArenaSnake* snake = &arena->snakes[i];
+        if (!snake->alive) continue;
+        if (arena->dying[i]) {
+            KillSnake(arena, i);
+            continue;
+        }
+
+        int cell = arena->heads[i];
+        SnakeSegment head = { cell % arena->width, cell / arena->width };
+        snake->body.PushFront(head);
+        arena->owner[cell] = i;
+        LogChange(arena, cell, i);
+
+        if (arena->foodSlot[cell] >= 0) {
+            RemoveFood(arena, cell);
+            snake->score += 10;
+            snake->growth++;
+        }
+    }
+
+    RefillFood(arena);
+}
+
+// Whether a cell is free and no other head can step into it on this tick
+static bool IsSafeCell(const Arena& arena, int index, int x, int y) {
+    if (!IsInside(arena, x, y) || arena.owner[y * arena.width + x] != NO_SNAKE) return false;
+    for (int d = LEFT; d <= DOWN; d++) {
+        int nx = x + DX[d];
+        int ny = y + DY[d];
+        if (!IsInside(arena, nx, ny)) continue;
+        int other = arena.owner[ny * arena.width + nx];
+        if (other != NO_SNAKE && other != index) {
+            const SnakeSegment& head = arena.snakes[other].body[0];
+            if (head.x == nx && head.y == ny) return false;
+        }
+    }
+    return true;
+}
+
+Direction ArenaBotMove(Arena* arena, int index, Rng* rng) {
+    ArenaSnake* snake = &arena->snakes[index];
+    const SnakeSegment& head = snake->body[0];
+
+    // Keep the current target while it is there; otherwise take the closest of a few samples
+    if ((snake->target < 0 || arena->foodSlot[snake->target] < 0) && !arena->foodCells.empty()) {
+        int best = INT32_MAX;
+        for (int i = 0; i < BOT_TARGET_SAMPLES; i++) {
+            int cell = arena->foodCells[rng->Below(static_cast<uint32_t>(arena->foodCells.size()))];
+            int distance = abs(cell % arena->width - head.x) + abs(cell / arena->width - head.y);
+            if (distance < best) {
+                best = distance;
+                snake->target = cell;
+            }
+        }
+    }
+
+    Direction choice = snake->dir;
+    int bestScore = INT32_MIN;
+    for (int d = LEFT; d <= DOWN; d++) {
+        Direction dir = static_cast<Direction>(d);
+        if (IsOpposite(dir, snake->dir)) continue;
+        int x = head.x + DX[d];
+        int y = head.y + DY[d];
+        if (!IsSafeCell(*arena, index, x, y)) continue;
+
+        // Prefer cells with room around them, then the food, then a little randomness
+        int room = 0;
+        for (int e = LEFT; e <= DOWN; e++) {
+            int nx = x + DX[e];
+            int ny = y + DY[e];
+            if (IsInside(*arena, nx, ny) && arena->owner[ny * arena->width + nx] == NO_SNAKE) room++;
+        }
+        int score = (room > 1 ? 1000 : room * 300) + static_cast<int>(rng->Below(3));
+        if (snake->target >= 0) {
+            score -= 10 * (abs(snake->target % arena->width - x) + abs(snake->target / arena->width - y));
+        }
+        if (score > bestScore) {
+            bestScore = score;
+            choice = dir;
+        }
+    }
+    return choice;
+}
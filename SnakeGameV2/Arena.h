@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Engine.h"
+#include "Rng.h"
+
+// Owner of a cell no snake covers
+const int NO_SNAKE = -1;
+
+// Value of a food cell in the change log
+const int ARENA_FOOD = -2;
+
+// Board size, number of snakes and number of food items kept on the board
+struct ArenaConfig {
+    int width = 40;
+    int height = 20;
+    int snakes = 8;
+    int food = 8;
+    uint64_t seed = 0;
+};
+
+struct ArenaSnake {
+    SnakeBody body; // grows its buffer with the snake instead of reserving the whole board
+    Direction dir;
+    Direction nextDir; // applied on the next tick unless it reverses the snake
+    int growth;
+    int score;
+    bool alive;
+    int target; // food cell a bot is heading for, or -1
+};
+
+// A cell that changed: its new owner, NO_SNAKE once empty, or ARENA_FOOD
+struct ArenaChange {
+    int cell;
+    int value;
+};
+
+// Many snakes on one board. Every cell records which snake covers it, so a moving
+// head is checked against all bodies with one lookup, and heads entering the same
+// cell are caught by stamping the cells claimed this tick. A tick therefore costs
+// O(snakes), plus the length of any snake that dies.
+struct Arena {
+    int width, height; // Board size including the walls
+    uint32_t tick;
+    int foodTarget;
+    int alive;
+    std::vector<ArenaSnake> snakes;
+    std::vector<int32_t> owner; // One entry per cell: the snake covering it, or NO_SNAKE
+    std::vector<int> foodCells;
+    std::vector<int> foodSlot; // Index of each cell in foodCells, or -1
+    Rng rng; // Food and spawn positions
+
+    // With logChanges set, every cell change is appended to changes in the order it
+    // happens, so replaying the log onto a copy of the board reproduces it. The
+    // caller clears the log once it has been consumed.
+    bool logChanges;
+    std::vector<ArenaChange> changes;
+
+    // Per-tick scratch
+    std::vector<int> heads; // Cell each snake moves into, -1 for a wall
+    std::vector<uint8_t> dying;
+    std::vector<uint32_t> claimTick; // Tick in which a head last entered each cell
+    std::vector<int32_t> claimBy; // The first snake whose head entered it
+};
+
+// Set up the board and spawn config.snakes snakes and config.food food items.
+// Board dimensions are clamped like Setup() does.
+void SetupArena(Arena* arena, const ArenaConfig& config);
+
+// Put a fresh three-segment snake in slot index (adding slots as needed) on free
+// cells with room ahead; returns false if no place was found
+bool SpawnSnake(Arena* arena, int index);
+
+// Take a snake off the board, as when its player leaves
+void RemoveSnake(Arena* arena, int index);
+
+// Set the direction a snake takes on the next tick
+void SteerSnake(Arena* arena, int index, Direction dir);
+
+// Move every living snake one cell. A snake dies when its head hits a wall or any
+// body, or enters the same cell as another head; heads swapping places count as
+// hitting bodies. Dead snakes are cleared from the board and eaten food is replaced.
+void ArenaTick(Arena* arena);
+
+// Bot steering: head for a nearby food item and avoid cells that are taken,
+// that another head could enter, or that lead into a dead end
+Direction ArenaBotMove(Arena* arena, int index, Rng* rng);
+
+inline bool IsArenaFood(const Arena& arena, int x, int y) {
+    return arena.foodSlot[y * arena.width + x] >= 0;
+}
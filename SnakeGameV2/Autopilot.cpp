@@ -0,0 +1,383 @@
+#include "Autopilot.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+// Searches look at the clock once per this many expanded cells
+const int CLOCK_CHECK_INTERVAL = 256;
+
+static const char* STRATEGY_NAMES[] = { "bfs", "astar", "hamiltonian" };
+
+static bool IsWallCell(const GameState& game, int cell) {
+    int x = cell % game.width;
+    int y = cell / game.width;
+    return x == 0 || y == 0 || x == game.width - 1 || y == game.height - 1;
+}
+
+static bool IsOccupiedCell(const GameState& game, int cell) {
+    return (game.occupied[cell >> 6] >> (cell & 63)) & 1;
+}
+
+static int HeadCell(const GameState& game) {
+    return game.snake[0].y * game.width + game.snake[0].x;
+}
+
+static int TailCell(const GameState& game) {
+    return game.snake.back().y * game.width + game.snake.back().x;
+}
+
+// Cell the tail leaves on the next move, or -1 while the snake is growing
+static int MovingTail(const GameState& game) {
+    return game.growth > 0 ? -1 : TailCell(game);
+}
+
+// Whether the head can step into the cell on the next move
+static bool IsFree(const GameState& game, int cell, int movingTail) {
+    return !IsWallCell(game, cell) && (!IsOccupiedCell(game, cell) || cell == movingTail);
+}
+
+static Direction DirectionBetween(const GameState& game, int from, int to) {
+    if (to == from - 1) return LEFT;
+    if (to == from + 1) return RIGHT;
+    if (to == from - game.width) return UP;
+    return DOWN;
+}
+
+static void NextStamp(Autopilot* pilot) {
+    if (++pilot->searchStamp == 0) {
+        fill(pilot->seen.begin(), pilot->seen.end(), 0);
+        fill(pilot->blocked.begin(), pilot->blocked.end(), 0);
+        pilot->searchStamp = 1;
+    }
+}
+
+// Fill pilot->path with the cells from start (exclusive) to target (inclusive)
+static void TracePath(Autopilot* pilot, int start, int target) {
+    pilot->path.clear();
+    for (int cell = target; cell != start; cell = pilot->from[cell]) {
+        pilot->path.push_back(cell);
+    }
+    reverse(pilot->path.begin(), pilot->path.end());
+}
+
+// Breadth-first search from the head to target through cells the head can enter;
+// the target itself may be occupied. Fills pilot->path and returns true if found.
+static bool SearchBfs(Autopilot* pilot, const GameState& game, int target, Clock::time_point deadline, bool* timedOut) {
+    NextStamp(pilot);
+    int head = HeadCell(game);
+    int tail = MovingTail(game);
+    const int offsets[4] = { -1, 1, -game.width, game.width };
+
+    pilot->frontier.clear();
+    pilot->frontier.push_back(head);
+    pilot->seen[head] = pilot->searchStamp;
+    for (size_t next = 0; next < pilot->frontier.size(); next++) {
+        if (next % CLOCK_CHECK_INTERVAL == 0 && Clock::now() > deadline) {
+            *timedOut = true;
+            return false;
+        }
+        int cell = pilot->frontier[next];
+        if (cell == target) {
+            TracePath(pilot, head, target);
+            return true;
+        }
+        for (int offset : offsets) {
+            int neighbor = cell + offset;
+            if (pilot->seen[neighbor] == pilot->searchStamp) continue;
+            if (neighbor != target && !IsFree(game, neighbor, tail)) continue;
+            pilot->seen[neighbor] = pilot->searchStamp;
+            pilot->from[neighbor] = cell;
+            pilot->frontier.push_back(neighbor);
+        }
+    }
+    return false;
+}
+
+// A* from the head to target with the Manhattan distance as the estimate
+static bool SearchAStar(Autopilot* pilot, const GameState& game, int target, Clock::time_point deadline, bool* timedOut) {
+    NextStamp(pilot);
+    int head = HeadCell(game);
+    int tail = MovingTail(game);
+    int targetX = target % game.width;
+    int targetY = target / game.width;
+    const int offsets[4] = { -1, 1, -game.width, game.width };
+    auto estimate = [&](int cell) {
+        return abs(cell % game.width - targetX) + abs(cell / game.width - targetY);
+    };
+
+    pilot->heap.clear();
+    pilot->heap.push_back((uint64_t(estimate(head)) << 32) | uint32_t(head));
+    pilot->seen[head] = pilot->searchStamp;
+    pilot->cost[head] = 0;
+    for (int expanded = 0; !pilot->heap.empty(); expanded++) {
+        if (expanded % CLOCK_CHECK_INTERVAL == 0 && Clock::now() > deadline) {
+            *timedOut = true;
+            return false;
+        }
+        pop_heap(pilot->heap.begin(), pilot->heap.end(), greater<uint64_t>());
+        int cell = static_cast<int>(pilot->heap.back() & 0xFFFFFFFF);
+        int score = static_cast<int>(pilot->heap.back() >> 32);
+        pilot->heap.pop_back();
+        if (cell == target) {
+            TracePath(pilot, head, target);
+            return true;
+        }
+        if (score > pilot->cost[cell] + estimate(cell)) continue; // stale entry
+
+        for (int offset : offsets) {
+            int neighbor = cell + offset;
+            if (neighbor != target && !IsFree(game, neighbor, tail)) continue;
+            int cost = pilot->cost[cell] + 1;
+            if (pilot->seen[neighbor] == pilot->searchStamp && pilot->cost[neighbor] <= cost) continue;
+            pilot->seen[neighbor] = pilot->searchStamp;
+            pilot->cost[neighbor] = cost;
+            pilot->from[neighbor] = cell;
+            pilot->heap.push_back((uint64_t(cost + estimate(neighbor)) << 32) | uint32_t(neighbor));
+            push_heap(pilot->heap.begin(), pilot->heap.end(), greater<uint64_t>());
+        }
+    }
+    return false;
+}
+
+// Whether, once the snake has followed pilot->path and eaten at its end, the
+// head could still reach the tail: if so the snake cannot have boxed itself in
+static bool TailReachableAfterPath(Autopilot* pilot, const GameState& game, Clock::time_point deadline, bool* timedOut) {
+    NextStamp(pilot);
+    const vector<int>& path = pilot->path;
+    size_t length = game.snake.size() + game.growth + 1;
+
+    // Lay out the imagined body: the path walked backwards, then the old body
+    size_t laid = 0;
+    int tail = -1;
+    for (size_t i = path.size(); i-- > 0 && laid < length; laid++) {
+        tail = path[i];
+        pilot->blocked[tail] = pilot->searchStamp;
+    }
+    for (size_t i = 0; i < game.snake.size() && laid < length; i++, laid++) {
+        if (i % CLOCK_CHECK_INTERVAL == 0 && Clock::now() > deadline) {
+            *timedOut = true;
+            return false;
+        }
+        tail = game.snake[i].y * game.width + game.snake[i].x;
+        pilot->blocked[tail] = pilot->searchStamp;
+    }
+    pilot->blocked[tail] = 0; // the tail moves on
+
+    int start = path.back();
+    const int offsets[4] = { -1, 1, -game.width, game.width };
+    pilot->frontier.clear();
+    pilot->frontier.push_back(start);
+    pilot->seen[start] = pilot->searchStamp;
+    for (size_t next = 0; next < pilot->frontier.size(); next++) {
+        if (next % CLOCK_CHECK_INTERVAL == 0 && Clock::now() > deadline) {
+            *timedOut = true;
+            return false;
+        }
+        for (int offset : offsets) {
+            int neighbor = pilot->frontier[next] + offset;
+            if (neighbor == tail) return true;
+            if (pilot->seen[neighbor] == pilot->searchStamp || pilot->blocked[neighbor] == pilot->searchStamp ||
+                IsWallCell(game, neighbor)) {
+                continue;
+            }
+            pilot->seen[neighbor] = pilot->searchStamp;
+            pilot->frontier.push_back(neighbor);
+        }
+    }
+    return false;
+}
+
+// Free neighbor of the head with the most free cells around it, or -1
+static int SafestNeighbor(const GameState& game) {
+    int head = HeadCell(game);
+    int tail = MovingTail(game);
+    const int offsets[4] = { -1, 1, -game.width, game.width };
+    int best = -1;
+    int bestRoom = -1;
+    for (int offset : offsets) {
+        int cell = head + offset;
+        if (!IsFree(game, cell, tail)) continue;
+        int room = 0;
+        for (int around : offsets) {
+            if (cell + around != head && IsFree(game, cell + around, tail)) room++;
+        }
+        if (room > bestRoom) {
+            best = cell;
+            bestRoom = room;
+        }
+    }
+    return best;
+}
+
+// A* to the food if the tail stays reachable, otherwise follow the tail
+static int SafePathMove(Autopilot* pilot, const GameState& game, Clock::time_point deadline, bool* timedOut) {
+    int food = game.foodY * game.width + game.foodX;
+    if (SearchAStar(pilot, game, food, deadline, timedOut) &&
+        TailReachableAfterPath(pilot, game, deadline, timedOut)) {
+        return pilot->path[0];
+    }
+    if (!*timedOut && SearchBfs(pilot, game, TailCell(game), deadline, timedOut) &&
+        (pilot->path.size() > 1 || game.growth == 0)) {
+        return pilot->path[0];
+    }
+    return -1;
+}
+
+// Next cell along the Hamiltonian cycle, cutting ahead towards the food while the
+// cut cannot land in the stretch of cycle the body still needs
+static int CycleMove(Autopilot* pilot, const GameState& game) {
+    if (pilot->cycleCells.empty()) return -1;
+
+    int cycleLength = static_cast<int>(pilot->cycleCells.size());
+    int head = HeadCell(game);
+    int tail = MovingTail(game);
+    int headIndex = pilot->cycleIndex[head];
+    int next = pilot->cycleCells[(headIndex + 1) % cycleLength];
+    if (!IsFree(game, next, tail)) return -1;
+
+    // Shortcuts are only safe once the body lies along the cycle, and only while it is short
+    bool aligned = pilot->cycleRun >= game.snake.size() + game.growth;
+    if (aligned && game.snake.size() * 2 < pilot->cycleCells.size()) {
+        auto ahead = [&](int cell) { return (pilot->cycleIndex[cell] - headIndex + cycleLength) % cycleLength; };
+        int toFood = ahead(game.foodY * game.width + game.foodX);
+        int toTail = ahead(TailCell(game));
+        int margin = game.growth + 4;
+        int best = 1;
+        const int offsets[4] = { -1, 1, -game.width, game.width };
+        for (int offset : offsets) {
+            int cell = head + offset;
+            if (!IsFree(game, cell, tail)) continue;
+            int distance = ahead(cell);
+            if (distance > best && distance <= toFood && distance < toTail - margin) {
+                best = distance;
+                next = cell;
+            }
+        }
+    }
+    return next;
+}
+
+// Lay a cycle through the inside of the board: along the first row, then
+// zigzag through the remaining rows and come back up the first column.
+// This needs an even number of rows; otherwise the board is walked by columns.
+static void BuildCycle(Autopilot* pilot, const GameState& game) {
+    int w = game.width - 2;
+    int h = game.height - 2;
+    bool byRows = (h % 2 == 0);
+    if (!byRows) swap(w, h);
+    if (h % 2 != 0 || w < 2) return; // no Hamiltonian cycle on an odd-by-odd board
+
+    auto add = [&](int i, int j) {
+        int x = byRows ? i : j;
+        int y = byRows ? j : i;
+        pilot->cycleCells.push_back((y + 1) * game.width + (x + 1));
+    };
+    for (int i = 0; i < w; i++) add(i, 0);
+    for (int j = 1; j < h; j++) {
+        if (j % 2 == 1) {
+            for (int i = w - 1; i >= 1; i--) add(i, j);
+        }
+        else {
+            for (int i = 1; i < w; i++) add(i, j);
+        }
+    }
+    for (int j = h - 1; j >= 1; j--) add(0, j);
+
+    // Run the cycle the way the snake is already heading
+    int head = HeadCell(game);
+    int neck = game.snake[1].y * game.width + game.snake[1].x;
+    auto at = find(pilot->cycleCells.begin(), pilot->cycleCells.end(), head);
+    auto after = (at + 1 == pilot->cycleCells.end()) ? pilot->cycleCells.begin() : at + 1;
+    if (*after == neck) reverse(pilot->cycleCells.begin(), pilot->cycleCells.end());
+
+    for (size_t i = 0; i < pilot->cycleCells.size(); i++) {
+        pilot->cycleIndex[pilot->cycleCells[i]] = static_cast<int>(i);
+    }
+}
+
+void InitAutopilot(Autopilot* pilot, const GameState& game, AutopilotStrategy strategy, int budgetUs) {
+    size_t cells = static_cast<size_t>(game.width) * game.height;
+    pilot->strategy = strategy;
+    pilot->budget = chrono::microseconds(budgetUs);
+    pilot->seen.assign(cells, 0);
+    pilot->blocked.assign(cells, 0);
+    pilot->from.assign(cells, -1);
+    pilot->cost.assign(cells, 0);
+    // Searches reuse these; a cell enters the A* heap at most once per neighbor
+    pilot->frontier.clear();
+    pilot->frontier.reserve(cells);
+    pilot->heap.clear();
+    pilot->heap.reserve(cells * 4);
+    pilot->path.clear();
+    pilot->path.reserve(cells);
+    pilot->searchStamp = 0;
+    pilot->cycleIndex.assign(cells, -1);
+    pilot->cycleCells.clear();
+    pilot->cycleRun = 0;
+    pilot->moves = 0;
+    pilot->overBudget = 0;
+    pilot->totalUs = 0;
+    pilot->maxUs = 0;
+
+    if (strategy == HAMILTONIAN) BuildCycle(pilot, game);
+}
+
+Direction ChooseMove(Autopilot* pilot, const GameState& game) {
+    Clock::time_point start = Clock::now();
+    Clock::time_point deadline = start + pilot->budget;
+    bool timedOut = false;
+    int head = HeadCell(game);
+    int next = -1;
+
+    switch (pilot->strategy) {
+    case GREEDY_BFS:
+        if (SearchBfs(pilot, game, game.foodY * game.width + game.foodX, deadline, &timedOut)) {
+            next = pilot->path[0];
+        }
+        break;
+    case ASTAR_SAFE:
+        next = SafePathMove(pilot, game, deadline, &timedOut);
+        break;
+    case HAMILTONIAN:
+        next = CycleMove(pilot, game);
+        if (next >= 0) {
+            pilot->cycleRun++;
+        }
+        else {
+            pilot->cycleRun = 0;
+            next = SafePathMove(pilot, game, deadline, &timedOut);
+        }
+        break;
+    }
+    if (next < 0) next = SafestNeighbor(game);
+
+    double us = chrono::duration<double, micro>(Clock::now() - start).count();
+    pilot->moves++;
+    pilot->totalUs += us;
+    pilot->maxUs = max(pilot->maxUs, us);
+    if (timedOut) pilot->overBudget++;
+
+    // Boxed in: keep going and let the game end
+    if (next < 0) return game.dir;
+    return DirectionBetween(game, head, next);
+}
+
+const char* StrategyName(AutopilotStrategy strategy) {
+    return STRATEGY_NAMES[strategy];
+}
+
+bool ParseStrategy(const char* name, AutopilotStrategy* strategy) {
+    for (int i = 0; i < 3; i++) {
+        if (strcmp(name, STRATEGY_NAMES[i]) == 0) {
+            *strategy = static_cast<AutopilotStrategy>(i);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "Engine.h"
+
+// Ways the autopilot can pick a move
+enum AutopilotStrategy {
+    GREEDY_BFS = 0, // shortest path to the food
+    ASTAR_SAFE, // A* to the food, taken only if the tail is still reachable afterwards
+    HAMILTONIAN // follow a cycle through every cell, with safe shortcuts; fills the board
+};
+
+// Computer player. ChooseMove() returns a direction for QueueTurn(), the same
+// interface the keyboard feeds. Path searches stop when the per-move time budget
+// runs out and fall back to a cheap safe move, so a move never takes much longer
+// than the budget however large the board is.
+struct Autopilot {
+    AutopilotStrategy strategy;
+    std::chrono::microseconds budget;
+
+    // Search scratch space sized to the board, reused between moves
+    std::vector<uint32_t> seen; // cells visited by the current search hold searchStamp
+    std::vector<uint32_t> blocked; // cells of the imagined body hold searchStamp
+    std::vector<int> from; // cell each visited cell was reached from
+    std::vector<int> cost; // A* path cost from the head
+    std::vector<int> frontier; // BFS queue
+    std::vector<uint64_t> heap; // A* open set: (estimate << 32) | cell
+    std::vector<int> path; // cells of the last path found, first step first
+    uint32_t searchStamp;
+
+    // Hamiltonian cycle over the cells inside the walls; empty if the board has none
+    std::vector<int> cycleIndex; // position of each cell on the cycle, -1 for walls
+    std::vector<int> cycleCells; // cells in cycle order
+    size_t cycleRun; // moves made along the cycle since the last move off it
+
+    // Statistics
+    long long moves;
+    long long overBudget;
+    double totalUs;
+    double maxUs;
+};
+
+// Prepare an autopilot for a freshly set up game. Building the Hamiltonian cycle
+// is the only step that scales with the board; budgetUs applies to ChooseMove().
+void InitAutopilot(Autopilot* pilot, const GameState& game, AutopilotStrategy strategy, int budgetUs);
+
+// Pick the next direction
+Direction ChooseMove(Autopilot* pilot, const GameState& game);
+
+// Name of a strategy for reports, and the reverse lookup (returns false if unknown)
+const char* StrategyName(AutopilotStrategy strategy);
+bool ParseStrategy(const char* name, AutopilotStrategy* strategy);
@@ -0,0 +1,192 @@
+#include "BatchEnv.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+const uint8_t CELL_WALL = 1;
+const uint8_t CELL_FOOD = 2;
+
+void BatchEnv::Reset(const BatchEnvConfig& config) {
+    games = max(1, config.games);
+    width = max(MIN_BOARD_SIZE, min(config.width, MAX_BOARD_SIZE));
+    height = max(MIN_BOARD_SIZE, min(config.height, MAX_BOARD_SIZE));
+    cells = width * height;
+    maxTicks = config.maxTicks;
+    nextSeed = config.seed;
+    episodes = 0;
+    episodeScore = 0;
+
+    // Same layout as the engine: walls on the border, food at least two cells in
+    cellKind.assign(cells, 0);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint8_t kind = 0;
+            if (x == 0 || y == 0 || x == width - 1 || y == height - 1) kind |= CELL_WALL;
+            if (x >= 2 && x < width - 2 && y >= 2 && y < height - 2) kind |= CELL_FOOD;
+            cellKind[y * width + x] = kind;
+        }
+    }
+
+    head.assign(games, 0);
+    food.assign(games, 0);
+    dir.assign(games, 0);
+    length.assign(games, 0);
+    growth.assign(games, 0);
+    ticks.assign(games, 0);
+    bodyStart.assign(games, 0);
+    freeCount.assign(games, 0);
+    score.assign(games, 0);
+    rng.assign(games, Rng());
+
+    size_t slices = static_cast<size_t>(games) * cells;
+    grid.assign(slices, 0);
+    body.assign(slices, 0);
+    freeCells.assign(slices, 0);
+    freeSlot.assign(slices, -1);
+
+    // Lay out the starting position once: every food cell free, then the snake
+    // taken out of the free list in the engine's order so food lands in the same places
+    startGrid.assign(cells, 0);
+    startFreeCells.assign(cells, 0);
+    startFreeSlot.assign(cells, -1);
+    startFreeCount = 0;
+    for (int cell = 0; cell < cells; cell++) {
+        if (cellKind[cell] & CELL_FOOD) {
+            startFreeSlot[cell] = startFreeCount;
+            startFreeCells[startFreeCount++] = cell;
+        }
+    }
+    int start = (height / 2) * width + width / 2;
+    for (int i = 0; i < 3; i++) {
+        int cell = start - i;
+        startGrid[cell] = 1;
+        int slot = startFreeSlot[cell];
+        if (slot >= 0) {
+            int last = startFreeCells[--startFreeCount];
+            startFreeCells[slot] = last;
+            startFreeSlot[last] = slot;
+            startFreeSlot[cell] = -1;
+        }
+    }
+
+    for (int i = 0; i < games; i++) ResetGame(i);
+}
+
+// Start a new episode with the next seed
+void BatchEnv::ResetGame(int game) {
+    size_t base = static_cast<size_t>(game) * cells;
+    memcpy(&grid[base], startGrid.data(), cells);
+    memcpy(&freeCells[base], startFreeCells.data(), startFreeCount * sizeof(int32_t));
+    memcpy(&freeSlot[base], startFreeSlot.data(), cells * sizeof(int32_t));
+
+    // Three segments in the middle of the board, head on the right
+    int start = (height / 2) * width + width / 2;
+    for (int i = 0; i < 3; i++) body[base + i] = start - i;
+
+    head[game] = start;
+    bodyStart[game] = 0;
+    length[game] = 3;
+    growth[game] = 0;
+    ticks[game] = 0;
+    score[game] = 0;
+    dir[game] = RIGHT - LEFT;
+    freeCount[game] = startFreeCount;
+    rng[game].Seed(nextSeed++);
+    PlaceFood(game);
+}
+
+// Put food on a uniformly chosen free cell; returns false if none is left
+bool BatchEnv::PlaceFood(int game) {
+    uint32_t count = freeCount[game];
+    if (count == 0) return false;
+    food[game] = freeCells[static_cast<size_t>(game) * cells + rng[game].Below(count)];
+    return true;
+}
+
+void BatchEnv::Step(const uint8_t* actions, float* rewards, uint8_t* dones, uint8_t* observations) {
+    // Cell offsets for left, right, up and down
+    const int offsets[ACTION_COUNT] = { -1, 1, -width, width };
+    const uint8_t reverse[ACTION_COUNT] = { 1, 0, 3, 2 };
+
+    for (int i = 0; i < games; i++) {
+        size_t base = static_cast<size_t>(i) * cells;
+        uint8_t* cellsTaken = &grid[base];
+        int32_t* freeList = &freeCells[base];
+        int32_t* slots = &freeSlot[base];
+        int32_t* ring = &body[base];
+
+        uint8_t action = actions[i];
+        if (action < ACTION_COUNT && action != reverse[dir[i]]) dir[i] = action;
+        int next = head[i] + offsets[dir[i]];
+        ticks[i]++;
+
+        // The tail moves on unless the snake is still growing
+        if (growth[i] > 0) {
+            growth[i]--;
+        }
+        else {
+            uint32_t tailPos = bodyStart[i] + length[i] - 1;
+            if (tailPos >= static_cast<uint32_t>(cells)) tailPos -= cells;
+            int tail = ring[tailPos];
+            cellsTaken[tail] = 0;
+            if (cellKind[tail] & CELL_FOOD) {
+                slots[tail] = freeCount[i];
+                freeList[freeCount[i]++] = tail;
+            }
+            length[i]--;
+        }
+
+        float reward = 0;
+        bool done = false;
+        if ((cellKind[next] & CELL_WALL) || cellsTaken[next]) {
+            reward = -1;
+            done = true;
+        }
+        else {
+            bodyStart[i] = (bodyStart[i] == 0 ? cells : bodyStart[i]) - 1;
+            ring[bodyStart[i]] = next;
+            length[i]++;
+            head[i] = next;
+            cellsTaken[next] = 1;
+            int slot = slots[next];
+            if (slot >= 0) {
+                int last = freeList[--freeCount[i]];
+                freeList[slot] = last;
+                slots[last] = slot;
+                slots[next] = -1;
+            }
+
+            if (next == food[i]) {
+                reward = 1;
+                score[i] += 10;
+                growth[i]++;
+                if (!PlaceFood(i)) done = true; // board cleared
+            }
+            if (maxTicks != 0 && ticks[i] >= maxTicks) done = true;
+        }
+
+        rewards[i] = reward;
+        dones[i] = done ? 1 : 0;
+        if (done) {
+            episodes++;
+            episodeScore += score[i];
+            ResetGame(i);
+        }
+    }
+
+    if (observations != nullptr) Observe(observations);
+}
+
+void BatchEnv::Observe(uint8_t* observations) const {
+    // Whole planes are block copies and fills, which the library runs with vector
+    // stores; only the head and food bytes are written one at a time
+    for (int i = 0; i < games; i++) {
+        uint8_t* planes = observations + static_cast<size_t>(i) * ObservationSize();
+        memcpy(planes + PLANE_BODY * cells, &grid[static_cast<size_t>(i) * cells], cells);
+        memset(planes + PLANE_HEAD * cells, 0, static_cast<size_t>(2) * cells);
+        planes[PLANE_HEAD * cells + head[i]] = 1;
+        planes[PLANE_FOOD * cells + food[i]] = 1;
+    }
+}
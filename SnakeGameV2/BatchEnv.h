@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Engine.h"
+#include "Rng.h"
+
+// Observation planes per game, each width * height bytes of 0 or 1, row by row
+enum ObservationPlane {
+    PLANE_BODY = 0, // every cell the snake covers, head included
+    PLANE_HEAD,
+    PLANE_FOOD,
+    OBSERVATION_PLANES
+};
+
+// Actions are the four directions: 0 left, 1 right, 2 up, 3 down. Anything else,
+// or a reversal, keeps the current direction.
+const int ACTION_COUNT = 4;
+
+struct BatchEnvConfig {
+    int games;
+    int width;
+    int height;
+    uint64_t seed; // game i of the first episode uses seed + i
+    uint32_t maxTicks; // episodes are cut off after this many steps; 0 for no limit
+};
+
+// Many games of the same board size stepped together for training agents. The
+// rules are the engine's (walls, growth, food on the inner cells, winning on a full
+// board), but games start moving right and the state is kept as one array per field
+// across all games, so a step touches a few cache lines per game and never allocates.
+// Finished games are reset in place, and their done flag tells the caller that the
+// observation already belongs to the next episode.
+class BatchEnv {
+public:
+    // Allocate the batch and start every game; the only call that allocates
+    void Reset(const BatchEnvConfig& config);
+
+    // Apply one action per game and advance every game by one tick. Writes one reward
+    // per game (+1 for food, -1 for dying, 0 otherwise), one done flag per game, and,
+    // unless observations is nullptr, ObservationSize() bytes per game.
+    void Step(const uint8_t* actions, float* rewards, uint8_t* dones, uint8_t* observations);
+
+    // Write the current observation of every game
+    void Observe(uint8_t* observations) const;
+
+    size_t ObservationSize() const { return static_cast<size_t>(OBSERVATION_PLANES) * cells; }
+    int size() const { return games; }
+
+    // Current episode of a game
+    int Score(int game) const { return score[game]; }
+    uint32_t Length(int game) const { return length[game]; }
+
+    // Totals over finished episodes
+    long long Episodes() const { return episodes; }
+    long long EpisodeScore() const { return episodeScore; }
+
+private:
+    void ResetGame(int game);
+    bool PlaceFood(int game);
+
+    int games;
+    int width;
+    int height;
+    int cells;
+    uint32_t maxTicks;
+    uint64_t nextSeed;
+
+    // One entry per game
+    std::vector<int32_t> head; // cell index
+    std::vector<int32_t> food;
+    std::vector<uint8_t> dir; // last action taken
+    std::vector<uint32_t> length;
+    std::vector<uint32_t> growth;
+    std::vector<uint32_t> ticks;
+    std::vector<uint32_t> bodyStart; // ring position of the head in the game's body slice
+    std::vector<uint32_t> freeCount;
+    std::vector<int32_t> score;
+    std::vector<Rng> rng;
+
+    // Shared by all games: bit 0 marks walls, bit 1 cells food may spawn on
+    std::vector<uint8_t> cellKind;
+
+    // Slices of a freshly reset game, copied in whole on every reset
+    std::vector<uint8_t> startGrid;
+    std::vector<int32_t> startFreeCells;
+    std::vector<int32_t> startFreeSlot;
+    uint32_t startFreeCount;
+
+    // One slice of cells entries per game
+    std::vector<uint8_t> grid; // 1 where the snake is; doubles as the body plane
+    std::vector<int32_t> body; // ring buffer of body cells
+    std::vector<int32_t> freeCells; // food cells not under the snake
+    std::vector<int32_t> freeSlot; // position of each cell in freeCells, -1 if absent
+
+    long long episodes;
+    long long episodeScore;
+};
@@ -0,0 +1,130 @@
+#include "BatchRunner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+using namespace std;
+
+// Games a worker still owns, [first, last) packed into one word so the owner
+// and thieves can both shrink it with a single compare-and-swap
+struct alignas(64) WorkRange {
+    atomic<uint64_t> games;
+    long long ticks;
+    long long steals;
+};
+
+static uint64_t PackRange(uint32_t first, uint32_t last) {
+    return (uint64_t(first) << 32) | last;
+}
+
+// Owner side: take the next game from the front of the range
+static bool TakeGame(WorkRange* range, uint32_t* game) {
+    uint64_t current = range->games.load(memory_order_relaxed);
+    for (;;) {
+        uint32_t first = static_cast<uint32_t>(current >> 32);
+        uint32_t last = static_cast<uint32_t>(current);
+        if (first >= last) return false;
+        if (range->games.compare_exchange_weak(current, PackRange(first + 1, last), memory_order_acq_rel)) {
+            *game = first;
+            return true;
+        }
+    }
+}
+
+// Thief side: move the back half of some other worker's range into our own,
+// trying victims in turn from the next worker on
+static bool StealGames(WorkRange* ranges, int workers, int self) {
+    for (int i = 1; i < workers; i++) {
+        WorkRange* victim = &ranges[(self + i) % workers];
+        uint64_t current = victim->games.load(memory_order_relaxed);
+        for (;;) {
+            uint32_t first = static_cast<uint32_t>(current >> 32);
+            uint32_t last = static_cast<uint32_t>(current);
+            if (first >= last) break;
+            uint32_t middle = first + (last - first) / 2;
+            if (victim->games.compare_exchange_weak(current, PackRange(first, middle), memory_order_acq_rel)) {
+                // Our own range is empty, and thieves leave empty ranges alone
+                ranges[self].games.store(PackRange(middle, last), memory_order_release);
+                ranges[self].steals++;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void RunWorker(const BatchConfig& config, WorkRange* ranges, int workers, int self, GameResult* results) {
+    // Game and search state live on the worker's own thread and are reused for every game
+    GameState game;
+    game.currentUser = nullptr;
+    Autopilot pilot;
+    GameConfig gameConfig = config.game;
+
+    uint32_t index;
+    while (TakeGame(&ranges[self], &index) || (StealGames(ranges, workers, self) && TakeGame(&ranges[self], &index))) {
+        gameConfig.seed = config.game.seed + index;
+        Setup(&game, gameConfig);
+        InitAutopilot(&pilot, game, config.strategy, config.budgetUs);
+
+        uint32_t tickLimit = config.tickLimit;
+        if (tickLimit == 0) tickLimit = static_cast<uint32_t>(game.width) * game.height * 64;
+        while (!game.gameOver && game.tick < tickLimit) {
+            QueueTurn(&game, ChooseMove(&pilot, game));
+            Logic(&game);
+        }
+
+        GameResult* result = &results[index];
+        result->seed = gameConfig.seed;
+        result->score = game.score;
+        result->length = static_cast<uint32_t>(game.snake.size());
+        result->ticks = game.tick;
+        result->won = game.won;
+        ranges[self].ticks += game.tick;
+    }
+}
+
+void RunBatch(const BatchConfig& config, vector<GameResult>* results, BatchStats* stats) {
+    int workers = config.threads > 0 ? config.threads : static_cast<int>(thread::hardware_concurrency());
+    workers = max(1, min(workers, max(1, config.games)));
+    results->assign(max(0, config.games), GameResult());
+
+    // Deal the games out in equal contiguous shares
+    vector<WorkRange> ranges(workers);
+    for (int i = 0; i < workers; i++) {
+        uint32_t first = static_cast<uint32_t>(static_cast<long long>(results->size()) * i / workers);
+        uint32_t last = static_cast<uint32_t>(static_cast<long long>(results->size()) * (i + 1) / workers);
+        ranges[i].games.store(PackRange(first, last), memory_order_relaxed);
+        ranges[i].ticks = 0;
+        ranges[i].steals = 0;
+    }
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (int i = 1; i < workers; i++) {
+        threads.emplace_back(RunWorker, cref(config), ranges.data(), workers, i, results->data());
+    }
+    RunWorker(config, ranges.data(), workers, 0, results->data());
+    for (thread& worker : threads) worker.join();
+
+    stats->threads = workers;
+    stats->seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    stats->ticks = 0;
+    stats->steals = 0;
+    for (const WorkRange& range : ranges) {
+        stats->ticks += range.ticks;
+        stats->steals += range.steals;
+    }
+}
+
+bool SaveResults(const vector<GameResult>& results, const string& path) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) return false;
+    fprintf(file, "seed,score,length,ticks,won\n");
+    for (const GameResult& result : results) {
+        fprintf(file, "%llu,%d,%u,%u,%d\n", static_cast<unsigned long long>(result.seed), result.score, result.length, result.ticks, result.won ? 1 : 0);
+    }
+    return fclose(file) == 0;
+}
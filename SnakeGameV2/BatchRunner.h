@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Autopilot.h"
+#include "Engine.h"
+
+// A run of headless games: game i is set up with game.seed + i and played by the
+// autopilot with the given strategy until it ends or reaches tickLimit
+struct BatchConfig {
+    GameConfig game;
+    int games;
+    AutopilotStrategy strategy;
+    int budgetUs;
+    int threads; // 0 uses every hardware thread
+    uint32_t tickLimit; // 0 allows 64 ticks per board cell
+};
+
+// How one game of the batch ended
+struct GameResult {
+    uint64_t seed;
+    int score;
+    uint32_t length;
+    uint32_t ticks;
+    bool won;
+};
+
+struct BatchStats {
+    int threads;
+    long long ticks;
+    long long steals; // successful steals of another worker's games
+    double seconds;
+};
+
+// Play the whole batch spread over worker threads. Each worker starts with an equal
+// share of the games and takes them from the front; a worker that runs out steals
+// the back half of another worker's remaining share, so a few long games do not
+// leave the other cores idle. Results are indexed by game whatever ran them.
+void RunBatch(const BatchConfig& config, std::vector<GameResult>* results, BatchStats* stats);
+
+// Write results as CSV with a header line
+bool SaveResults(const std::vector<GameResult>& results, const std::string& path);
@@ -0,0 +1,249 @@
+#include "Console.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <conio.h>
+#include <windows.h>
+#else
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Milliseconds left until deadline, for a wait of timeoutMs that began at start
+static int RemainingMs(int timeoutMs, chrono::steady_clock::time_point start) {
+    if (timeoutMs < 0) return -1;
+    auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+    return static_cast<int>(max<long long>(0, timeoutMs - elapsed));
+}
+
+#ifdef _WIN32
+// Key from the console keyboard buffer; extended keys arrive as 0 or 224
+// followed by a scan code and are skipped
+static int ReadConsoleKey(int timeoutMs) {
+    auto start = chrono::steady_clock::now();
+    while (true) {
+        if (_kbhit()) {
+            int key = _getch();
+            if (key == 0 || key == 224) {
+                _getch();
+                continue;
+            }
+            if (key == '\b') return KEY_BACKSPACE;
+            if (key == '\r') return KEY_ENTER;
+            return key;
+        }
+        if (RemainingMs(timeoutMs, start) == 0) return KEY_NONE;
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+}
+#endif
+
+class AnsiConsole : public Console {
+public:
+    AnsiConsole(int inputFd, int outputFd) : input(inputFd), output(outputFd), rawMode(false) {}
+
+    void Open(const char* title) override {
+#ifdef _WIN32
+        HANDLE handle = GetStdHandle(STD_OUTPUT_HANDLE);
+        DWORD mode = 0;
+        if (GetConsoleMode(handle, &mode)) SetConsoleMode(handle, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+        savedCodePage = GetConsoleOutputCP();
+        SetConsoleOutputCP(65001); // UTF-8, for the wall glyphs
+#else
+        // Keys arrive one at a time without echo; Ctrl+C still interrupts
+        if (tcgetattr(input, &saved) == 0) {
+            termios raw = saved;
+            raw.c_lflag &= ~(ICANON | ECHO);
+            raw.c_iflag &= ~(IXON | ICRNL);
+            raw.c_cc[VMIN] = 1;
+            raw.c_cc[VTIME] = 0;
+            rawMode = tcsetattr(input, TCSAFLUSH, &raw) == 0;
+        }
+#endif
+        // Alternate screen, hidden cursor, 80x25 where the terminal allows it, and the title
+        char setup[160];
+        int n = snprintf(setup, sizeof(setup), "\x1b[?1049h\x1b[?25l\x1b[8;%d;%dt\x1b]0;%s\x07",
+            SCREEN_HEIGHT, SCREEN_WIDTH, title);
+        WriteAll(setup, static_cast<size_t>(min(n, static_cast<int>(sizeof(setup)) - 1)));
+    }
+
+    void Close() override {
+        const char restore[] = "\x1b[0m\x1b[?25h\x1b[?1049l";
+        WriteAll(restore, sizeof(restore) - 1);
+#ifdef _WIN32
+        SetConsoleOutputCP(savedCodePage);
+#else
+        if (rawMode) tcsetattr(input, TCSAFLUSH, &saved);
+        rawMode = false;
+#endif
+    }
+
+    size_t Show(Renderer* renderer) override {
+        renderer->utf8 = true;
+        size_t size = Present(renderer);
+        if (size > 0) WriteAll(renderer->out.data(), size);
+        return size;
+    }
+
+    int ReadKey(int timeoutMs) override {
+#ifdef _WIN32
+        return ReadConsoleKey(timeoutMs);
+#else
+        auto start = chrono::steady_clock::now();
+        while (true) {
+            unsigned char ch;
+            if (!ReadByte(RemainingMs(timeoutMs, start), &ch)) {
+                if (RemainingMs(timeoutMs, start) == 0) return KEY_NONE;
+                continue;
+            }
+            if (ch == 127 || ch == '\b') return KEY_BACKSPACE;
+            if (ch == '\r' || ch == '\n') return KEY_ENTER;
+            if (ch != 27) return ch;
+
+            // A lone Escape, or the start of a sequence sent by an arrow or
+            // function key, which ends with a byte in 0x40-0x7E
+            unsigned char next;
+            if (!ReadByte(5, &next)) return KEY_ESCAPE;
+            if (next == '[' || next == 'O') {
+                while (ReadByte(5, &next) && (next < 0x40 || next > 0x7E)) {}
+            }
+        }
+#endif
+    }
+
+private:
+    // Write everything, retrying after partial writes and interruptions
+    void WriteAll(const char* data, size_t size) {
+#ifdef _WIN32
+        DWORD written;
+        WriteConsoleA(GetStdHandle(STD_OUTPUT_HANDLE), data, static_cast<DWORD>(size), &written, NULL);
+        writes++;
+        bytes += size;
+#else
+        while (size > 0) {
+            ssize_t written = write(output, data, size);
+            writes++;
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+            bytes += written;
+        }
+#endif
+    }
+
+#ifndef _WIN32
+    // One byte from the input if it arrives within timeoutMs. At end of input
+    // the wait is slept out so callers waiting for a key do not spin.
+    bool ReadByte(int timeoutMs, unsigned char* ch) {
+        pollfd fd = { input, POLLIN, 0 };
+        int ready = poll(&fd, 1, timeoutMs);
+        if (ready > 0 && read(input, ch, 1) == 1) return true;
+        if (ready > 0 || (ready < 0 && errno != EINTR)) {
+            this_thread::sleep_for(chrono::milliseconds(timeoutMs < 0 ? 100 : timeoutMs));
+        }
+        return false;
+    }
+#endif
+
+    int input;
+    int output;
+    bool rawMode;
+#ifdef _WIN32
+    unsigned savedCodePage = 0;
+#else
+    termios saved;
+#endif
+};
+
+Console* CreateAnsiConsole(int inputFd, int outputFd) {
+    return new AnsiConsole(inputFd, outputFd);
+}
+
+#ifdef _WIN32
+class Win32Console : public Console {
+public:
+    Win32Console() : handle(GetStdHandle(STD_OUTPUT_HANDLE)), buffer(SCREEN_WIDTH * SCREEN_HEIGHT) {}
+
+    void Open(const char* title) override {
+        SetConsoleTitleA(title);
+        system("mode con: cols=80 lines=25");
+        SetCursorVisible(false);
+    }
+
+    void Close() override {
+        SetConsoleTextAttribute(handle, (BLACK << 4) | WHITE);
+        SetCursorVisible(true);
+    }
+
+    size_t Show(Renderer* renderer) override {
+        int left, top, right, bottom;
+        if (!ChangedRegion(*renderer, &left, &top, &right, &bottom)) return 0;
+
+        // Copy the changed rectangle into a buffer of its own size
+        int width = right - left + 1;
+        int height = bottom - top + 1;
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                const Cell& cell = renderer->back.cells[top + y][left + x];
+                CHAR_INFO& info = buffer[y * width + x];
+                info.Char.AsciiChar = cell.ch;
+                info.Attributes = cell.color;
+            }
+        }
+        COORD size = { static_cast<SHORT>(width), static_cast<SHORT>(height) };
+        COORD origin = { 0, 0 };
+        SMALL_RECT region = { static_cast<SHORT>(left), static_cast<SHORT>(top), static_cast<SHORT>(right), static_cast<SHORT>(bottom) };
+        WriteConsoleOutputA(handle, buffer.data(), size, origin, &region);
+        CommitFrame(renderer);
+
+        size_t written = static_cast<size_t>(width) * height * sizeof(CHAR_INFO);
+        writes++;
+        bytes += written;
+        return written;
+    }
+
+    int ReadKey(int timeoutMs) override {
+        return ReadConsoleKey(timeoutMs);
+    }
+
+private:
+    void SetCursorVisible(bool visible) {
+        CONSOLE_CURSOR_INFO info;
+        info.dwSize = 100;
+        info.bVisible = visible ? TRUE : FALSE;
+        SetConsoleCursorInfo(handle, &info);
+    }
+
+    HANDLE handle;
+    vector<CHAR_INFO> buffer;
+};
+
+Console* CreateWin32Console() {
+    return new Win32Console();
+}
+#endif
+
+Console* CreateConsole() {
+#ifdef _WIN32
+    const char* kind = getenv("SNAKE_CONSOLE");
+    if (kind != nullptr && strcmp(kind, "ansi") == 0) return CreateAnsiConsole(0, 1);
+    return CreateWin32Console();
+#else
+    return CreateAnsiConsole(STDIN_FILENO, STDOUT_FILENO);
+#endif
+}
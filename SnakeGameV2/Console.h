@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include "Renderer.h"
+
+// Keys ReadKey() reports besides plain characters
+const int KEY_NONE = -1; // no key before the timeout
+const int KEY_BACKSPACE = 8;
+const int KEY_ENTER = 13;
+const int KEY_ESCAPE = 27;
+
+// Where the console front end draws and reads keys. Every screen is built in
+// a Renderer's back frame and put on screen with one Show() call, which writes
+// only the cells that changed, in a single write to the terminal.
+class Console {
+public:
+    virtual ~Console() {}
+
+    // Take over the terminal: size, title, hidden cursor and unbuffered keys
+    virtual void Open(const char* title) = 0;
+
+    // Give the terminal back as it was found
+    virtual void Close() = 0;
+
+    // Show the renderer's back frame; returns the bytes written
+    virtual size_t Show(Renderer* renderer) = 0;
+
+    // Wait up to timeoutMs for a key, or forever if timeoutMs is negative.
+    // Enter and Backspace are reported as KEY_ENTER and KEY_BACKSPACE on every
+    // platform; arrow and function keys are skipped.
+    virtual int ReadKey(int timeoutMs) = 0;
+
+    // Output counters, for benchmarks
+    long long writes = 0; // write calls made to the terminal
+    long long bytes = 0;
+};
+
+// VT/ANSI terminal on a pair of file descriptors: cursor moves and color changes
+// are encoded by Present() into the renderer's preallocated buffer, box-drawing
+// glyphs as UTF-8, and each frame goes out in one write(). On Windows the
+// descriptors are ignored and the console must support VT sequences.
+Console* CreateAnsiConsole(int inputFd, int outputFd);
+
+#ifdef _WIN32
+// Win32 console API: the changed rectangle of each frame is copied into the
+// screen buffer with one WriteConsoleOutputA() call
+Console* CreateWin32Console();
+#endif
+
+// The platform's usual backend: the Win32 console on Windows, unless the
+// SNAKE_CONSOLE environment variable is "ansi", and the ANSI terminal on stdin
+// and stdout elsewhere
+Console* CreateConsole();
@@ -0,0 +1,318 @@
+#include "Engine.h"
+
+#include <algorithm>
+#include <cstring>
+#include "FixedBoard.h"
+
+using namespace std;
+
+// The engine is written once against a board geometry: RuntimeBoard reads the
+// size from the game, CompiledBoard<W, H> has it and its layout fixed at
+// compile time. Each geometry gives the row width, the food and blocked-cell
+// tests, and how to lay out an empty board.
+
+struct RuntimeBoard {
+    static int Width(const GameState* game) {
+        return game->width;
+    }
+
+    // Food spawns at least two cells away from the walls
+    static bool IsFoodCell(const GameState* game, int x, int y) {
+        return x >= 2 && x < game->width - 2 && y >= 2 && y < game->height - 2;
+    }
+
+    // A head on this cell hits a wall or the body
+    static bool IsBlocked(const GameState* game, int x, int y) {
+        return x <= 0 || x >= game->width - 1 || y <= 0 || y >= game->height - 1 || IsOccupied(*game, x, y);
+    }
+
+    // Nothing occupied and every food cell free. This is the only place that
+    // visits every cell, so ticks cost the same on any board.
+    static void ClearBoard(GameState* game) {
+        size_t cells = static_cast<size_t>(game->width) * game->height;
+        game->occupied.assign((cells + 63) / 64, 0);
+        game->freeSlot.assign(cells, -1);
+        game->freeCells.clear();
+        game->freeCells.reserve(cells);
+        for (int y = 0; y < game->height; y++) {
+            for (int x = 0; x < game->width; x++) {
+                if (IsFoodCell(game, x, y)) {
+                    game->freeSlot[y * game->width + x] = static_cast<int>(game->freeCells.size());
+                    game->freeCells.push_back(y * game->width + x);
+                }
+            }
+        }
+    }
+};
+
+template <int W, int H>
+struct CompiledBoard {
+    typedef FixedBoard<W, H> Layout;
+
+    static int Width(const GameState*) {
+        return W;
+    }
+
+    static bool IsFoodCell(const GameState*, int x, int y) {
+        return IsFixedFoodCell(W, H, x, y);
+    }
+
+    // Walls and body in one bit test. A head one step past a wall can only be
+    // there after the game ended; cells off the top or bottom count as walls.
+    static bool IsBlocked(const GameState* game, int x, int y) {
+        unsigned cell = static_cast<unsigned>(y * W + x);
+        if (cell >= static_cast<unsigned>(Layout::CELLS)) return true;
+        return ((Layout::WALLS[cell >> 6] | game->occupied[cell >> 6]) >> (cell & 63)) & 1;
+    }
+
+    // The empty board is copied from the compile-time tables
+    static void ClearBoard(GameState* game) {
+        game->occupied.resize(Layout::WORDS);
+        memset(game->occupied.data(), 0, Layout::WORDS * sizeof(uint64_t));
+        game->freeSlot.resize(Layout::CELLS);
+        memcpy(game->freeSlot.data(), Layout::FREE_SLOTS.data(), sizeof(Layout::FREE_SLOTS));
+        game->freeCells.reserve(Layout::CELLS);
+        game->freeCells.resize(Layout::FOOD_CELLS);
+        memcpy(game->freeCells.data(), Layout::FREE_CELLS.data(), sizeof(Layout::FREE_CELLS));
+    }
+};
+
+// Mark a cell as covered by the snake and take it out of the free list
+template <class Board>
+static void Occupy(GameState* game, const SnakeSegment& segment) {
+    int cell = segment.y * Board::Width(game) + segment.x;
+    game->occupied[cell >> 6] |= uint64_t(1) << (cell & 63);
+
+    int slot = game->freeSlot[cell];
+    if (slot >= 0) {
+        // Swap the last free cell into the hole
+        int last = game->freeCells.back();
+        game->freeCells[slot] = last;
+        game->freeSlot[last] = slot;
+        game->freeCells.pop_back();
+        game->freeSlot[cell] = -1;
+    }
+}
+
+// Clear a cell the snake has left and return it to the free list
+template <class Board>
+static void Vacate(GameState* game, const SnakeSegment& segment) {
+    int cell = segment.y * Board::Width(game) + segment.x;
+    game->occupied[cell >> 6] &= ~(uint64_t(1) << (cell & 63));
+
+    if (Board::IsFoodCell(game, segment.x, segment.y)) {
+        game->freeSlot[cell] = static_cast<int>(game->freeCells.size());
+        game->freeCells.push_back(cell);
+    }
+}
+
+// Put food on a uniformly chosen free cell; returns false if none is left
+template <class Board>
+static bool PlaceFood(GameState* game) {
+    if (game->freeCells.empty()) return false;
+    int cell = game->freeCells[game->rng.Below(static_cast<uint32_t>(game->freeCells.size()))];
+    game->foodX = cell % Board::Width(game);
+    game->foodY = cell / Board::Width(game);
+    return true;
+}
+
+// Set up the initial game state on a board whose size is already set
+template <class Board>
+static void SetupBoard(GameState* game) {
+    game->tick = 0;
+    game->gameOver = false;
+    game->dir = STOP;
+    game->pendingCount = 0;
+    game->score = 0;
+    game->speed = START_SPEED; // Initial game speed
+    game->won = false;
+    game->growth = 0;
+
+    // Every food cell starts out free; capacities are reserved so moves never allocate
+    Board::ClearBoard(game);
+
+    // Initialize snake with 3 segments; the body can never outgrow the board
+    game->snake.Reset(static_cast<size_t>(game->width) * game->height);
+    SnakeSegment head;
+    head.x = game->width / 2;
+    head.y = game->height / 2;
+    game->snake.PushBack(head);
+
+    for (int i = 1; i < 3; i++) {
+        SnakeSegment segment;
+        segment.x = head.x - i;
+        segment.y = head.y;
+        game->snake.PushBack(segment);
+    }
+    for (size_t i = 0; i < game->snake.size(); i++) {
+        Occupy<Board>(game, game->snake[i]);
+    }
+
+    // Place food at random position
+    PlaceFood<Board>(game);
+}
+
+// Change direction unless it would reverse the snake
+void Turn(GameState* game, Direction dir) {
+    switch (dir) {
+    case LEFT:
+        if (game->dir != RIGHT) game->dir = LEFT;
+        break;
+    case RIGHT:
+        if (game->dir != LEFT) game->dir = RIGHT;
+        break;
+    case UP:
+        if (game->dir != DOWN) game->dir = UP;
+        break;
+    case DOWN:
+        if (game->dir != UP) game->dir = DOWN;
+        break;
+    default:
+        break;
+    }
+}
+
+// Whether two directions point opposite ways
+static bool IsReverse(Direction a, Direction b) {
+    return (a == LEFT && b == RIGHT) || (a == RIGHT && b == LEFT) ||
+        (a == UP && b == DOWN) || (a == DOWN && b == UP);
+}
+
+// Queue a turn to be applied on a later tick
+bool QueueTurn(GameState* game, Direction dir) {
+    if (dir == STOP || game->pendingCount == TURN_BUFFER_SIZE) return false;
+
+    Direction last = (game->pendingCount > 0) ? game->pendingTurns[game->pendingCount - 1] : game->dir;
+    if (dir == last || IsReverse(dir, last)) return false;
+    game->pendingTurns[game->pendingCount++] = dir;
+    return true;
+}
+
+// Update game logic
+template <class Board>
+static void LogicOn(GameState* game) {
+    game->tick++;
+
+    // Take the oldest queued turn
+    if (game->pendingCount > 0) {
+        game->dir = game->pendingTurns[0];
+        game->pendingCount--;
+        for (int i = 0; i < game->pendingCount; i++) {
+            game->pendingTurns[i] = game->pendingTurns[i + 1];
+        }
+    }
+
+    // If the game hasn't started yet, don't update
+    if (game->dir == STOP) return;
+
+    // Move the head
+    SnakeSegment head = game->snake[0];
+    switch (game->dir) {
+    case LEFT:
+        head.x--;
+        break;
+    case RIGHT:
+        head.x++;
+        break;
+    case UP:
+        head.y--;
+        break;
+    case DOWN:
+        head.y++;
+        break;
+    default:
+        break;
+    }
+
+    // The rest of the snake follows: drop the tail and push the new head,
+    // unless the snake is still growing from food eaten on an earlier tick
+    if (game->growth > 0) {
+        game->growth--;
+    }
+    else {
+        Vacate<Board>(game, game->snake.back());
+        game->snake.PopBack();
+    }
+    game->snake.PushFront(head);
+
+    // Check for collisions with walls and self
+    if (Board::IsBlocked(game, head.x, head.y)) {
+        game->gameOver = true;
+        return;
+    }
+    Occupy<Board>(game, head);
+
+    // Check if food is eaten
+    if (game->snake[0].x == game->foodX && game->snake[0].y == game->foodY) {
+        // Increase score
+        game->score += 10;
+
+        // Grow by one segment: the tail stays in place on the next move
+        game->growth++;
+
+        // Generate new food; once the snake covers every food cell there is nowhere
+        // left to put it and the game is won, though cells near the walls may be empty
+        if (!PlaceFood<Board>(game)) {
+            game->won = true;
+            game->gameOver = true;
+            return;
+        }
+
+        // Increase game speed slightly with each food eaten (up to a limit)
+        if (game->speed > MIN_SPEED) {
+            game->speed -= SPEED_STEP;
+        }
+    }
+}
+
+// Run the game headless from a recorded input stream
+template <class Board>
+static size_t SimulateOn(GameState* game, const Direction* inputs, size_t count) {
+    size_t ticks = 0;
+    while (ticks < count && !game->gameOver) {
+        QueueTurn(game, inputs[ticks]);
+        LogicOn<Board>(game);
+        ticks++;
+    }
+    return ticks;
+}
+
+template <int W, int H>
+static constexpr BoardKernel CompileKernel() {
+    typedef CompiledBoard<W, H> Board;
+    return BoardKernel{ W, H, SetupBoard<Board>, LogicOn<Board>, SimulateOn<Board> };
+}
+
+// The default board, and square boards the size of its sides
+static constexpr BoardKernel BOARD_KERNELS[] = {
+    CompileKernel<WIDTH, HEIGHT>(),
+    CompileKernel<HEIGHT, HEIGHT>(),
+    CompileKernel<WIDTH, WIDTH>(),
+};
+
+const BoardKernel* FindBoardKernel(int width, int height) {
+    for (const BoardKernel& kernel : BOARD_KERNELS) {
+        if (kernel.width == width && kernel.height == height) return &kernel;
+    }
+    return nullptr;
+}
+
+// Set up the initial game state
+void Setup(GameState* game, const GameConfig& config) {
+    game->width = max(MIN_BOARD_SIZE, min(config.width, MAX_BOARD_SIZE));
+    game->height = max(MIN_BOARD_SIZE, min(config.height, MAX_BOARD_SIZE));
+    game->rng.Seed(config.seed);
+    game->kernel = config.specialized ? FindBoardKernel(game->width, game->height) : nullptr;
+    if (game->kernel != nullptr) game->kernel->setup(game);
+    else SetupBoard<RuntimeBoard>(game);
+}
+
+void Logic(GameState* game) {
+    if (game->kernel != nullptr) game->kernel->logic(game);
+    else LogicOn<RuntimeBoard>(game);
+}
+
+size_t Simulate(GameState* game, const Direction* inputs, size_t count) {
+    if (game->kernel != nullptr) return game->kernel->simulate(game, inputs, count);
+    return SimulateOn<RuntimeBoard>(game, inputs, count);
+}
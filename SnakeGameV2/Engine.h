@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Rng.h"
+
+struct User;
+struct GameState;
+
+// Default board size
+const int WIDTH = 30;
+const int HEIGHT = 20;
+
+// Limits on board dimensions: the snake and its food area must fit, and every
+// cell index must fit in an int
+const int MIN_BOARD_SIZE = 6;
+const int MAX_BOARD_SIZE = 16384;
+
+// Milliseconds between ticks: a game starts at START_SPEED and each food eaten
+// takes SPEED_STEP off, down to MIN_SPEED
+const int START_SPEED = 150;
+const int MIN_SPEED = 50;
+const int SPEED_STEP = 5;
+
+// Directions
+enum Direction { STOP = 0, LEFT, RIGHT, UP, DOWN };
+
+// Snake segment structure
+struct SnakeSegment {
+    int x, y;
+};
+
+// Snake body stored head-first in a fixed-capacity ring buffer, so a move
+// only writes the new head and drops the old tail
+class SnakeBody {
+public:
+    // Empty the body and make room for up to capacity segments
+    void Reset(size_t capacity) {
+        cells.assign(capacity, SnakeSegment{ 0, 0 });
+        first = 0;
+        count = 0;
+    }
+
+    void PushFront(const SnakeSegment& segment) {
+        first = (first == 0) ? cells.size() - 1 : first - 1;
+        cells[first] = segment;
+        count++;
+    }
+
+    void PushBack(const SnakeSegment& segment) {
+        cells[Slot(count)] = segment;
+        count++;
+    }
+
+    void PopBack() {
+        count--;
+    }
+
+    // Move the segments into a larger buffer, head first; for bodies that are not
+    // sized to the board up front
+    void Grow(size_t capacity) {
+        std::vector<SnakeSegment> larger(capacity, SnakeSegment{ 0, 0 });
+        for (size_t i = 0; i < count; i++) larger[i] = cells[Slot(i)];
+        cells.swap(larger);
+        first = 0;
+    }
+
+    // Segment i counted from the head
+    const SnakeSegment& operator[](size_t i) const {
+        return cells[Slot(i)];
+    }
+
+    const SnakeSegment& back() const {
+        return cells[Slot(count - 1)];
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    size_t capacity() const {
+        return cells.size();
+    }
+
+private:
+    size_t Slot(size_t i) const {
+        size_t slot = first + i;
+        return (slot >= cells.size()) ? slot - cells.size() : slot;
+    }
+
+    std::vector<SnakeSegment> cells;
+    size_t first = 0; // slot of the head
+    size_t count = 0;
+};
+
+// Turns a player can queue ahead of the snake, one applied per tick
+const int TURN_BUFFER_SIZE = 3;
+
+// Board size and seed a game is set up with
+struct GameConfig {
+    int width = WIDTH;
+    int height = HEIGHT;
+    uint64_t seed = 0;
+    bool specialized = true; // run on a kernel built for the board size when there is one
+};
+
+// Setup and tick code compiled for one board size: cell indices use a constant
+// width, the walls and the starting free-cell list are tables built at compile
+// time (FixedBoard.h), and the wall and body checks are one bit test against
+// the wall mask and the occupancy. Games run exactly as on the generic code.
+struct BoardKernel {
+    int width, height;
+    void (*setup)(GameState* game); // everything in Setup() after the size is set
+    void (*logic)(GameState* game);
+    size_t (*simulate)(GameState* game, const Direction* inputs, size_t count);
+};
+
+// The kernel for a width x height board, or nullptr if that size runs on the
+// generic code. Kernels are built for the default board and other common sizes.
+const BoardKernel* FindBoardKernel(int width, int height);
+
+// Game state structure
+struct GameState {
+    int width, height; // Board size including the walls
+    uint32_t tick; // Logic() calls since Setup()
+    bool gameOver;
+    int score;
+    Direction dir;
+    Direction pendingTurns[TURN_BUFFER_SIZE]; // Queued turns, oldest first
+    int pendingCount;
+    SnakeBody snake; // Ring buffer holding the snake body, head first
+    int growth; // Segments still to be added by keeping the tail in place
+    int foodX, foodY;
+    bool won; // The snake covers every cell food spawns on (two or more in from the walls)
+    std::vector<uint64_t> occupied; // One bit per board cell in row-major order, set where the snake is
+    std::vector<int> freeCells; // Cells food may spawn on that the snake does not cover
+    std::vector<int> freeSlot; // Index of each cell in freeCells, or -1
+    User* currentUser; // Pointer to current user
+    int speed; // Game speed (milliseconds between updates)
+    Rng rng; // Per-game random source for food placement
+    const BoardKernel* kernel; // Code specialized for the board size, or nullptr
+};
+
+// Set up the initial game state; the seed fixes every food position of the game.
+// Board dimensions are clamped to [MIN_BOARD_SIZE, MAX_BOARD_SIZE].
+void Setup(GameState* game, const GameConfig& config);
+
+// Whether a snake segment covers the cell
+inline bool IsOccupied(const GameState& game, int x, int y) {
+    int cell = y * game.width + x;
+    return (game.occupied[cell >> 6] >> (cell & 63)) & 1;
+}
+
+// Change direction, ignoring a turn straight back into the body
+void Turn(GameState* game, Direction dir);
+
+// Queue a turn for a later tick. Each turn is checked against the direction the
+// snake will have after the turns already queued, so a quick double turn cannot
+// reverse it into itself. Turns that change nothing or overflow the buffer are
+// ignored; returns whether the turn was queued.
+bool QueueTurn(GameState* game, Direction dir);
+
+// Advance the game by one tick, applying the oldest queued turn first
+void Logic(GameState* game);
+
+// Apply one input per tick until the inputs run out or the game ends.
+// STOP means "no key this tick". Returns the number of ticks run. The board
+// kernel is picked once for the whole run.
+size_t Simulate(GameState* game, const Direction* inputs, size_t count);
@@ -0,0 +1,53 @@
+#include "FileSync.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+bool SyncFile(FILE* file) {
+    if (fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Move the finished temporary file over path in one step, and make the move
+// itself durable
+static bool ReplaceWith(const string& tempPath, const string& path) {
+#ifdef _WIN32
+    return MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    if (rename(tempPath.c_str(), path.c_str()) != 0) return false;
+
+    // The new name lives in the directory, which is synced in turn
+    size_t slash = path.find_last_of('/');
+    string directory = (slash == string::npos) ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int fd = open(directory.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+#endif
+}
+
+bool WriteFileAtomically(const string& path, const void* data, size_t size) {
+    string tempPath = path + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(data, 1, size, file) == size && SyncFile(file);
+    ok = (fclose(file) == 0) && ok;
+    if (!ok || !ReplaceWith(tempPath, path)) {
+        remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+// Push what has been written to file through the C library and the OS to the
+// disk, so a later write is never on disk before an earlier one
+bool SyncFile(FILE* file);
+
+// Write a whole file so that a crash at any point leaves either the old file at
+// path or the new one, never a torn mix: the bytes go to path + ".tmp", are
+// synced, and the temporary file is then renamed over path
+bool WriteFileAtomically(const std::string& path, const void* data, size_t size);
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Layout tables for a board whose size is known at compile time, in the
+// engine's row-major cell order. The compiler builds them, so a game of that
+// size starts by copying them instead of visiting every cell.
+
+// Walls are the border cells; food spawns at least two cells away from them
+constexpr bool IsFixedWall(int width, int height, int x, int y) {
+    return x == 0 || y == 0 || x == width - 1 || y == height - 1;
+}
+
+constexpr bool IsFixedFoodCell(int width, int height, int x, int y) {
+    return x >= 2 && x < width - 2 && y >= 2 && y < height - 2;
+}
+
+// One bit per cell, set on the walls
+template <int W, int H>
+constexpr std::array<uint64_t, (W * H + 63) / 64> FixedWallMask() {
+    std::array<uint64_t, (W * H + 63) / 64> mask = {};
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            int cell = y * W + x;
+            if (IsFixedWall(W, H, x, y)) mask[cell >> 6] |= uint64_t(1) << (cell & 63);
+        }
+    }
+    return mask;
+}
+
+// Every food cell in row-major order: the free-cell list of an empty board
+template <int W, int H>
+constexpr std::array<int, (W - 4) * (H - 4)> FixedFreeCells() {
+    std::array<int, (W - 4) * (H - 4)> cells = {};
+    int count = 0;
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            if (IsFixedFoodCell(W, H, x, y)) cells[count++] = y * W + x;
+        }
+    }
+    return cells;
+}
+
+// Index of each cell in FixedFreeCells(), or -1
+template <int W, int H>
+constexpr std::array<int, W * H> FixedFreeSlots() {
+    std::array<int, W * H> slots = {};
+    int count = 0;
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            slots[y * W + x] = IsFixedFoodCell(W, H, x, y) ? count++ : -1;
+        }
+    }
+    return slots;
+}
+
+template <int W, int H>
+struct FixedBoard {
+    static_assert(W >= 6 && H >= 6, "the snake and its food area must fit");
+
+    static constexpr int WIDTH = W;
+    static constexpr int HEIGHT = H;
+    static constexpr int CELLS = W * H;
+    static constexpr int WORDS = (CELLS + 63) / 64; // 64-bit words of an occupancy bitboard
+    static constexpr int FOOD_CELLS = (W - 4) * (H - 4);
+
+    static constexpr std::array<uint64_t, WORDS> WALLS = FixedWallMask<W, H>();
+    static constexpr std::array<int, FOOD_CELLS> FREE_CELLS = FixedFreeCells<W, H>();
+    static constexpr std::array<int, CELLS> FREE_SLOTS = FixedFreeSlots<W, H>();
+};
@@ -0,0 +1,67 @@
+#include "GameLoop.h"
+
+using namespace std;
+
+// Handle the player's keys, recording each accepted turn
+static void PlayerKeys(GameInput* input, GameState* game, Replay* replay, Profiler* profiler) {
+    auto now = chrono::steady_clock::now();
+    InputEvent event;
+    while (input->keys->Pop(&event)) {
+        RecordLatency(&input->latency, event, now);
+        RecordValue(&profiler->metrics[METRIC_INPUT_LATENCY], chrono::duration_cast<chrono::nanoseconds>(now - event.time).count());
+        switch (event.key) {
+        case 'a':
+        case 'A':
+            if (QueueTurn(game, LEFT)) RecordTurn(replay, *game, LEFT);
+            break;
+        case 'd':
+        case 'D':
+            if (QueueTurn(game, RIGHT)) RecordTurn(replay, *game, RIGHT);
+            break;
+        case 'w':
+        case 'W':
+            if (QueueTurn(game, UP)) RecordTurn(replay, *game, UP);
+            break;
+        case 's':
+        case 'S':
+            if (QueueTurn(game, DOWN)) RecordTurn(replay, *game, DOWN);
+            break;
+        case 'p':
+        case 'P':
+            input->showHud = !input->showHud;
+            break;
+        case 'x':
+        case 'X':
+            input->quit = true;
+            return; // turns pressed after X are not taken
+        }
+    }
+}
+
+// Demo mode: the autopilot steers and any key press ends the game
+static void DemoKeys(GameInput* input, GameState* game, Replay* replay, Autopilot* pilot) {
+    InputEvent event;
+    while (input->keys->Pop(&event)) {
+        game->gameOver = true;
+    }
+    if (game->gameOver) return;
+
+    Direction dir = ChooseMove(pilot, *game);
+    if (QueueTurn(game, dir)) RecordTurn(replay, *game, dir);
+}
+
+bool RunGameTick(GameInput* input, GameState* game, Replay* replay, Autopilot* pilot, Profiler* profiler,
+    FrameSample* sample) {
+    {
+        ProfileScope scope(&profiler->metrics[METRIC_INPUT], &sample->inputNs);
+        if (pilot != nullptr) DemoKeys(input, game, replay, pilot);
+        else PlayerKeys(input, game, replay, profiler);
+    }
+    if (input->quit) return false;
+    {
+        ProfileScope scope(&profiler->metrics[METRIC_LOGIC], &sample->logicNs);
+        Logic(game);
+    }
+    sample->ticksRun++;
+    return true;
+}
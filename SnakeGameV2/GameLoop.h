@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Autopilot.h"
+#include "Engine.h"
+#include "InputQueue.h"
+#include "Profiler.h"
+#include "Replay.h"
+
+// Keys reaching a running game: the queue the input thread fills, and what
+// the keys asked for besides steering
+struct GameInput {
+    InputQueue* keys;
+    InputLatency latency;
+    bool showHud; // P toggles the line of live performance figures
+    bool quit; // X puts the game aside
+};
+
+// One tick of a running game. The queued keys are handled first: WASD turns,
+// recorded in the replay, P and X as above. In a demo (pilot set) the
+// autopilot steers instead and any key ends the game. Then Logic() runs.
+// Input and logic times go to the profiler and the frame sample. Returns false
+// without running the tick once X is pressed, so the game can be saved
+// between ticks.
+bool RunGameTick(GameInput* input, GameState* game, Replay* replay, Autopilot* pilot, Profiler* profiler,
+    FrameSample* sample);
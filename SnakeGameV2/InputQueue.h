@@ -0,0 +1,32 @@
+#pragma once
+
+#include <chrono>
+#include "SpscQueue.h"
+
+// A key press stamped with the time it was read
+struct InputEvent {
+    int key;
+    std::chrono::steady_clock::time_point time;
+};
+
+// Keys travel from the input thread to the game loop through this queue
+typedef SpscQueue<InputEvent, 64> InputQueue;
+
+// Time from key press to the tick that consumed it
+struct InputLatency {
+    long long count;
+    double sumUs;
+    double maxUs;
+};
+
+inline void RecordLatency(InputLatency* latency, const InputEvent& event,
+    std::chrono::steady_clock::time_point now) {
+    double us = std::chrono::duration<double, std::micro>(now - event.time).count();
+    latency->count++;
+    latency->sumUs += us;
+    if (us > latency->maxUs) latency->maxUs = us;
+}
+
+inline double MeanLatencyUs(const InputLatency& latency) {
+    return latency.count > 0 ? latency.sumUs / latency.count : 0.0;
+}
@@ -0,0 +1,126 @@
+#include "Leaderboard.h"
+
+using namespace std;
+
+void Leaderboard::Clear() {
+    nodes.clear();
+    freeNodes.clear();
+    root = -1;
+    count = 0;
+}
+
+// Whether (score, user) ranks ahead of the node: higher score first, then username
+bool Leaderboard::Before(int score, const User* user, const Node& node) const {
+    if (score != node.score) return score > node.score;
+    return user->username < node.user->username;
+}
+
+void Leaderboard::Pull(int node) {
+    nodes[node].size = 1 + Size(nodes[node].left) + Size(nodes[node].right);
+}
+
+// Split into the nodes ranked ahead of (score, user) and the nodes behind it
+void Leaderboard::Split(int node, int score, const User* user, int* left, int* right) {
+    if (node < 0) {
+        *left = *right = -1;
+        return;
+    }
+    if (Before(score, user, nodes[node])) {
+        Split(nodes[node].left, score, user, left, &nodes[node].left);
+        *right = node;
+    }
+    else {
+        Split(nodes[node].right, score, user, &nodes[node].right, right);
+        *left = node;
+    }
+    Pull(node);
+}
+
+int Leaderboard::Merge(int left, int right) {
+    if (left < 0) return right;
+    if (right < 0) return left;
+    if (nodes[left].priority > nodes[right].priority) {
+        nodes[left].right = Merge(nodes[left].right, right);
+        Pull(left);
+        return left;
+    }
+    nodes[right].left = Merge(left, nodes[right].left);
+    Pull(right);
+    return right;
+}
+
+void Leaderboard::Insert(const User* user) {
+    // xorshift32 priorities keep the treap balanced in expectation
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    int node;
+    if (!freeNodes.empty()) {
+        node = freeNodes.back();
+        freeNodes.pop_back();
+    }
+    else {
+        node = static_cast<int>(nodes.size());
+        nodes.push_back(Node());
+    }
+    nodes[node] = Node{ user, user->highScore, seed, 1, -1, -1 };
+
+    int left, right;
+    Split(root, user->highScore, user, &left, &right);
+    root = Merge(Merge(left, node), right);
+    count++;
+}
+
+// Remove the node keyed (score, user) from the subtree; returns the new subtree root
+int Leaderboard::Erase(int node, int score, const User* user) {
+    if (node < 0) return -1;
+    if (nodes[node].user == user && nodes[node].score == score) {
+        freeNodes.push_back(node);
+        count--;
+        return Merge(nodes[node].left, nodes[node].right);
+    }
+    if (Before(score, user, nodes[node])) {
+        nodes[node].left = Erase(nodes[node].left, score, user);
+    }
+    else {
+        nodes[node].right = Erase(nodes[node].right, score, user);
+    }
+    Pull(node);
+    return node;
+}
+
+void Leaderboard::UpdateScore(User* user, int newScore) {
+    root = Erase(root, user->highScore, user);
+    user->highScore = newScore;
+    Insert(user);
+}
+
+void Leaderboard::Collect(int node, size_t k, const User** out, size_t* filled) const {
+    if (node < 0 || *filled >= k) return;
+    Collect(nodes[node].left, k, out, filled);
+    if (*filled < k) out[(*filled)++] = nodes[node].user;
+    Collect(nodes[node].right, k, out, filled);
+}
+
+size_t Leaderboard::Top(size_t k, const User** out) const {
+    size_t filled = 0;
+    Collect(root, k, out, &filled);
+    return filled;
+}
+
+size_t Leaderboard::Rank(const User& user) const {
+    // Count the nodes ranked ahead of the user on the way down
+    size_t ahead = 0;
+    int node = root;
+    while (node >= 0) {
+        if (Before(user.highScore, &user, nodes[node]) || nodes[node].user == &user) {
+            node = nodes[node].left;
+        }
+        else {
+            ahead += Size(nodes[node].left) + 1;
+            node = nodes[node].right;
+        }
+    }
+    return ahead + 1;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "UserStore.h"
+
+// Users ranked by high score, best first, kept in a treap with subtree sizes.
+// A score change, the top-k query and a user's rank each cost O(log n) plus
+// the size of the answer, without copying or sorting the user set.
+// Ties are broken by username so the order is stable.
+class Leaderboard {
+public:
+    void Clear();
+
+    // Add a user under its current high score
+    void Insert(const User* user);
+
+    // Move a user to a new high score and store it in the user
+    void UpdateScore(User* user, int newScore);
+
+    // Fill out with up to k users from the top, best first; returns how many
+    size_t Top(size_t k, const User** out) const;
+
+    // 1-based position of the user
+    size_t Rank(const User& user) const;
+
+    size_t size() const { return count; }
+
+private:
+    struct Node {
+        const User* user;
+        int score; // score the node is keyed by
+        uint32_t priority;
+        uint32_t size; // nodes in this subtree
+        int left, right; // child node indices, -1 if none
+    };
+
+    bool Before(int score, const User* user, const Node& node) const;
+    uint32_t Size(int node) const { return node < 0 ? 0 : nodes[node].size; }
+    void Pull(int node);
+    void Split(int node, int score, const User* user, int* left, int* right);
+    int Merge(int left, int right);
+    int Erase(int node, int score, const User* user);
+    void Collect(int node, size_t k, const User** out, size_t* filled) const;
+
+    std::vector<Node> nodes;
+    std::vector<int> freeNodes;
+    int root = -1;
+    size_t count = 0;
+    uint32_t seed = 2463534242u;
+};
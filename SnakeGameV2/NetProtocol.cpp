@@ -0,0 +1,157 @@
+#include "NetProtocol.h"
+
+#include <algorithm>
+#include "Varint.h"
+
+using namespace std;
+
+// Cell values are sent offset so that ARENA_FOOD and NO_SNAKE are small and unsigned
+const int VALUE_OFFSET = 2;
+
+static size_t BeginFrame(vector<uint8_t>* out, NetMessage type) {
+    size_t start = out->size();
+    out->resize(start + FRAME_HEADER_SIZE);
+    out->push_back(static_cast<uint8_t>(type));
+    return start;
+}
+
+static void EndFrame(vector<uint8_t>* out, size_t start) {
+    uint32_t length = static_cast<uint32_t>(out->size() - start - FRAME_HEADER_SIZE);
+    for (size_t i = 0; i < FRAME_HEADER_SIZE; i++) {
+        (*out)[start + i] = static_cast<uint8_t>(length >> (8 * i));
+    }
+}
+
+static void PutCell(vector<uint8_t>* out, int cell, int value) {
+    PutVarint(out, static_cast<uint64_t>(cell));
+    PutVarint(out, static_cast<uint64_t>(value + VALUE_OFFSET));
+}
+
+void EncodeWelcome(const Arena& arena, int player, vector<uint8_t>* out) {
+    size_t start = BeginFrame(out, MSG_WELCOME);
+    PutVarint(out, arena.width);
+    PutVarint(out, arena.height);
+    PutVarint(out, player);
+    EndFrame(out, start);
+}
+
+void EncodeKeyframe(const Arena& arena, vector<uint8_t>* out) {
+    size_t start = BeginFrame(out, MSG_KEYFRAME);
+    PutVarint(out, arena.tick);
+
+    // Walk the bodies and the food list rather than the board, so the cost follows
+    // what is on the board, not its size
+    size_t count = arena.foodCells.size();
+    for (const ArenaSnake& snake : arena.snakes) {
+        if (snake.alive) count += snake.body.size();
+    }
+    PutVarint(out, count);
+    for (int i = 0; i < static_cast<int>(arena.snakes.size()); i++) {
+        const ArenaSnake& snake = arena.snakes[i];
+        if (!snake.alive) continue;
+        for (size_t j = 0; j < snake.body.size(); j++) {
+            PutCell(out, snake.body[j].y * arena.width + snake.body[j].x, i);
+        }
+    }
+    for (int cell : arena.foodCells) PutCell(out, cell, ARENA_FOOD);
+    EndFrame(out, start);
+}
+
+void EncodeDelta(const Arena& arena, vector<uint8_t>* out) {
+    size_t start = BeginFrame(out, MSG_DELTA);
+    PutVarint(out, arena.tick);
+    PutVarint(out, arena.changes.size());
+    for (const ArenaChange& change : arena.changes) PutCell(out, change.cell, change.value);
+    EndFrame(out, start);
+}
+
+uint32_t FrameLength(const uint8_t* data, size_t size) {
+    if (size < FRAME_HEADER_SIZE) return 0;
+    uint32_t length = 0;
+    for (size_t i = 0; i < FRAME_HEADER_SIZE; i++) length |= uint32_t(data[i]) << (8 * i);
+    return length;
+}
+
+void ResetMirror(ArenaMirror* mirror) {
+    mirror->width = 0;
+    mirror->height = 0;
+    mirror->player = NO_SNAKE;
+    mirror->tick = 0;
+    mirror->synced = false;
+    mirror->cells.clear();
+    mirror->nonEmpty = 0;
+    mirror->keyframeMismatches = 0;
+}
+
+// Read a cell and value pair, checking the cell is on the board
+static bool GetCell(const ArenaMirror& mirror, const uint8_t** data, const uint8_t* end, int* cell, int* value) {
+    uint64_t rawCell, rawValue;
+    if (!GetVarint(data, end, &rawCell) || !GetVarint(data, end, &rawValue)) return false;
+    if (rawCell >= mirror.cells.size() || rawValue > INT32_MAX) return false;
+    *cell = static_cast<int>(rawCell);
+    *value = static_cast<int>(rawValue) - VALUE_OFFSET;
+    return true;
+}
+
+static void SetCell(ArenaMirror* mirror, int cell, int value) {
+    if (mirror->cells[cell] != NO_SNAKE) mirror->nonEmpty--;
+    if (value != NO_SNAKE) mirror->nonEmpty++;
+    mirror->cells[cell] = value;
+}
+
+bool ApplyFrame(ArenaMirror* mirror, const uint8_t* data, size_t size) {
+    const uint8_t* end = data + size;
+    if (data == end) return false;
+    uint8_t type = *data++;
+    uint64_t a, b, c;
+
+    switch (type) {
+    case MSG_WELCOME:
+        if (!GetVarint(&data, end, &a) || !GetVarint(&data, end, &b) || !GetVarint(&data, end, &c)) return false;
+        if (a < MIN_BOARD_SIZE || b < MIN_BOARD_SIZE || a > MAX_BOARD_SIZE || b > MAX_BOARD_SIZE) return false;
+        mirror->width = static_cast<int>(a);
+        mirror->height = static_cast<int>(b);
+        mirror->player = static_cast<int>(c);
+        mirror->cells.assign(static_cast<size_t>(a) * b, NO_SNAKE);
+        mirror->nonEmpty = 0;
+        mirror->synced = false;
+        return true;
+
+    case MSG_KEYFRAME: {
+        if (!GetVarint(&data, end, &a) || !GetVarint(&data, end, &b)) return false;
+
+        // A board built from deltas must hold exactly the keyframe's cells
+        bool matches = mirror->synced && mirror->tick == a && mirror->nonEmpty == b;
+        const uint8_t* cells = data;
+        for (uint64_t i = 0; i < b && matches; i++) {
+            int cell, value;
+            if (!GetCell(*mirror, &data, end, &cell, &value)) return false;
+            matches = (mirror->cells[cell] == value);
+        }
+        if (mirror->synced && !matches) mirror->keyframeMismatches++;
+
+        data = cells;
+        fill(mirror->cells.begin(), mirror->cells.end(), NO_SNAKE);
+        mirror->nonEmpty = 0;
+        for (uint64_t i = 0; i < b; i++) {
+            int cell, value;
+            if (!GetCell(*mirror, &data, end, &cell, &value)) return false;
+            SetCell(mirror, cell, value);
+        }
+        mirror->tick = static_cast<uint32_t>(a);
+        mirror->synced = true;
+        return data == end;
+    }
+
+    case MSG_DELTA:
+        if (!GetVarint(&data, end, &a) || !GetVarint(&data, end, &b)) return false;
+        for (uint64_t i = 0; i < b; i++) {
+            int cell, value;
+            if (!GetCell(*mirror, &data, end, &cell, &value)) return false;
+            if (mirror->synced) SetCell(mirror, cell, value);
+        }
+        mirror->tick = static_cast<uint32_t>(a);
+        return data == end;
+    }
+    return false;
+}
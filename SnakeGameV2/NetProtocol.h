@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Arena.h"
+
+// Server-to-client messages. Each is framed as a 4-byte little-endian length
+// followed by that many bytes, the first being the message type.
+enum NetMessage {
+    MSG_WELCOME = 1, // board width and height, the player's snake index
+    MSG_KEYFRAME, // tick, then every covered or food cell with its value
+    MSG_DELTA // tick, then the cells that changed since the previous tick, in order
+};
+
+// Client-to-server messages are single bytes holding a Direction
+
+const size_t FRAME_HEADER_SIZE = 4;
+const uint32_t MAX_FRAME_SIZE = 1 << 24;
+
+// Append complete frames to out
+void EncodeWelcome(const Arena& arena, int player, std::vector<uint8_t>* out);
+void EncodeKeyframe(const Arena& arena, std::vector<uint8_t>* out);
+void EncodeDelta(const Arena& arena, std::vector<uint8_t>* out); // from arena.changes
+
+// Length of the frame at the start of data, or 0 if the header is incomplete
+uint32_t FrameLength(const uint8_t* data, size_t size);
+
+// The board as a client sees it, rebuilt from the frames it receives
+struct ArenaMirror {
+    int width, height;
+    int player;
+    uint32_t tick;
+    bool synced; // a keyframe has arrived, so deltas can be applied
+    std::vector<int32_t> cells; // NO_SNAKE, ARENA_FOOD or a snake index per cell
+    size_t nonEmpty;
+    long long keyframeMismatches; // keyframes that disagreed with the board built from deltas
+};
+
+void ResetMirror(ArenaMirror* mirror);
+
+// Apply one frame body (without its length header); returns false if it is malformed
+bool ApplyFrame(ArenaMirror* mirror, const uint8_t* data, size_t size);
@@ -0,0 +1,109 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace std;
+
+static const char* METRIC_NAMES[METRIC_COUNT] = {
+    "frame_ns", "wait_ns", "input_ns", "logic_ns", "draw_ns", "frame_bytes", "input_latency_ns",
+    "load_users_ns", "save_user_ns"
+};
+
+static int BucketOf(uint64_t value) {
+    if (value < HISTOGRAM_LINEAR) return static_cast<int>(value);
+    int exponent = 63;
+    while (!(value >> exponent)) exponent--;
+    int sub = static_cast<int>((value >> (exponent - 3)) & (HISTOGRAM_SUB_BUCKETS - 1));
+    return HISTOGRAM_LINEAR + (exponent - 4) * HISTOGRAM_SUB_BUCKETS + sub;
+}
+
+// Largest value that falls in a bucket
+static uint64_t BucketLimit(int bucket) {
+    if (bucket < HISTOGRAM_LINEAR) return bucket;
+    int exponent = 4 + (bucket - HISTOGRAM_LINEAR) / HISTOGRAM_SUB_BUCKETS;
+    uint64_t sub = (bucket - HISTOGRAM_LINEAR) % HISTOGRAM_SUB_BUCKETS;
+    uint64_t width = uint64_t(1) << (exponent - 3);
+    return (uint64_t(1) << exponent) + (sub + 1) * width - 1;
+}
+
+void ResetProfiler(Profiler* profiler) {
+    for (Histogram& histogram : profiler->metrics) {
+        for (atomic<uint64_t>& bucket : histogram.buckets) bucket.store(0, memory_order_relaxed);
+        histogram.count.store(0, memory_order_relaxed);
+        histogram.sum.store(0, memory_order_relaxed);
+        histogram.max.store(0, memory_order_relaxed);
+    }
+    profiler->traceCount = 0;
+    profiler->start = chrono::steady_clock::now();
+}
+
+void RecordValue(Histogram* histogram, uint64_t value) {
+    histogram->buckets[BucketOf(value)].fetch_add(1, memory_order_relaxed);
+    histogram->count.fetch_add(1, memory_order_relaxed);
+    histogram->sum.fetch_add(value, memory_order_relaxed);
+    uint64_t max = histogram->max.load(memory_order_relaxed);
+    while (value > max && !histogram->max.compare_exchange_weak(max, value, memory_order_relaxed)) {}
+}
+
+void RecordFrame(Profiler* profiler, const FrameSample& sample) {
+    RecordValue(&profiler->metrics[METRIC_FRAME], sample.frameNs);
+    RecordValue(&profiler->metrics[METRIC_FRAME_BYTES], sample.bytes);
+    profiler->trace[profiler->traceCount % TRACE_FRAMES] = sample;
+    profiler->traceCount++;
+}
+
+uint64_t Percentile(const Histogram& histogram, double fraction) {
+    uint64_t count = histogram.count.load(memory_order_relaxed);
+    if (count == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(fraction * count);
+    if (rank >= count) rank = count - 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += histogram.buckets[i].load(memory_order_relaxed);
+        if (seen > rank) return min(BucketLimit(i), histogram.max.load(memory_order_relaxed));
+    }
+    return histogram.max.load(memory_order_relaxed);
+}
+
+double MeanValue(const Histogram& histogram) {
+    uint64_t count = histogram.count.load(memory_order_relaxed);
+    return count > 0 ? double(histogram.sum.load(memory_order_relaxed)) / count : 0.0;
+}
+
+const char* MetricName(ProfileMetric metric) {
+    return METRIC_NAMES[metric];
+}
+
+bool WriteProfileJson(const Profiler& profiler, const string& path) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) return false;
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - profiler.start).count();
+    fprintf(file, "{\n  \"seconds\": %.3f,\n  \"metrics\": {\n", seconds);
+    for (int i = 0; i < METRIC_COUNT; i++) {
+        const Histogram& histogram = profiler.metrics[i];
+        fprintf(file, "    \"%s\": { \"count\": %llu, \"mean\": %.1f, \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"max\": %llu }%s\n",
+            METRIC_NAMES[i], static_cast<unsigned long long>(histogram.count.load()), MeanValue(histogram),
+            static_cast<unsigned long long>(Percentile(histogram, 0.50)),
+            static_cast<unsigned long long>(Percentile(histogram, 0.90)),
+            static_cast<unsigned long long>(Percentile(histogram, 0.99)),
+            static_cast<unsigned long long>(histogram.max.load()), i + 1 < METRIC_COUNT ? "," : "");
+    }
+    fprintf(file, "  }\n}\n");
+    return fclose(file) == 0;
+}
+
+bool WriteTraceCsv(const Profiler& profiler, const string& path) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) return false;
+    fprintf(file, "tick,ticks_run,frame_ns,wait_ns,input_ns,logic_ns,draw_ns,bytes\n");
+    uint64_t first = profiler.traceCount > TRACE_FRAMES ? profiler.traceCount - TRACE_FRAMES : 0;
+    for (uint64_t i = first; i < profiler.traceCount; i++) {
+        const FrameSample& sample = profiler.trace[i % TRACE_FRAMES];
+        fprintf(file, "%u,%u,%llu,%llu,%llu,%llu,%llu,%llu\n", sample.tick, sample.ticksRun,
+            static_cast<unsigned long long>(sample.frameNs), static_cast<unsigned long long>(sample.waitNs),
+            static_cast<unsigned long long>(sample.inputNs), static_cast<unsigned long long>(sample.logicNs),
+            static_cast<unsigned long long>(sample.drawNs), static_cast<unsigned long long>(sample.bytes));
+    }
+    return fclose(file) == 0;
+}
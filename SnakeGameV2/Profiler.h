@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// What the profiler measures, in nanoseconds except for METRIC_FRAME_BYTES
+enum ProfileMetric {
+    METRIC_FRAME = 0, // one pass of the game loop, waiting included
+    METRIC_WAIT, // sleeping until the next tick
+    METRIC_INPUT,
+    METRIC_LOGIC,
+    METRIC_DRAW, // building, diffing and writing a frame
+    METRIC_FRAME_BYTES, // bytes written to the console per frame
+    METRIC_INPUT_LATENCY, // key press to the tick that handled it
+    METRIC_LOAD_USERS,
+    METRIC_SAVE_USER,
+    METRIC_COUNT
+};
+
+// Values below HISTOGRAM_LINEAR get a bucket each; every power of two above
+// that is split into HISTOGRAM_SUB_BUCKETS equal buckets
+const int HISTOGRAM_LINEAR = 16;
+const int HISTOGRAM_SUB_BUCKETS = 8;
+const int HISTOGRAM_BUCKETS = HISTOGRAM_LINEAR + (64 - 4) * HISTOGRAM_SUB_BUCKETS;
+
+// Log-linear histogram: a bucket is at most 1/8 of its value wide, so percentiles
+// are read back within 12.5%. Recording is a handful of relaxed atomic operations
+// with no locks, so any thread may record while another reads.
+struct Histogram {
+    std::atomic<uint64_t> buckets[HISTOGRAM_BUCKETS];
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> max;
+};
+
+// Phase times of one pass of the game loop, for the trace
+struct FrameSample {
+    uint32_t tick;
+    uint32_t ticksRun; // ticks the pass ran, 0 if it only drew
+    uint64_t frameNs;
+    uint64_t waitNs;
+    uint64_t inputNs;
+    uint64_t logicNs;
+    uint64_t drawNs;
+    uint64_t bytes;
+};
+
+// Frames kept for the trace file
+const size_t TRACE_FRAMES = 4096;
+
+struct Profiler {
+    Histogram metrics[METRIC_COUNT];
+    FrameSample trace[TRACE_FRAMES]; // ring of the latest frames; written by the game loop only
+    uint64_t traceCount;
+    std::chrono::steady_clock::time_point start;
+};
+
+void ResetProfiler(Profiler* profiler);
+
+void RecordValue(Histogram* histogram, uint64_t value);
+
+// Record a finished pass of the game loop: its frame time, bytes and trace entry
+void RecordFrame(Profiler* profiler, const FrameSample& sample);
+
+// Smallest bucket value that at least fraction of the recorded values fall under
+uint64_t Percentile(const Histogram& histogram, double fraction);
+double MeanValue(const Histogram& histogram);
+
+const char* MetricName(ProfileMetric metric);
+
+// Summary of every metric (count, mean, p50, p90, p99, max) as JSON
+bool WriteProfileJson(const Profiler& profiler, const std::string& path);
+
+// The traced frames, oldest first, as CSV
+bool WriteTraceCsv(const Profiler& profiler, const std::string& path);
+
+// Times the enclosing scope into a histogram, and optionally adds the time to a
+// per-frame total. Costs two clock reads.
+class ProfileScope {
+public:
+    explicit ProfileScope(Histogram* histogram, uint64_t* total = nullptr)
+        : histogram(histogram), total(total), start(std::chrono::steady_clock::now()) {}
+
+    ~ProfileScope() {
+        uint64_t ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        RecordValue(histogram, ns);
+        if (total != nullptr) *total += ns;
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    Histogram* histogram;
+    uint64_t* total;
+    std::chrono::steady_clock::time_point start;
+};
@@ -0,0 +1,331 @@
+#include "Renderer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "Arena.h"
+
+using namespace std;
+
+// Snake colors in the arena, by snake index
+static const int ARENA_COLORS[] = { LIGHTGREEN, LIGHTBLUE, YELLOW, LIGHTMAGENTA, LIGHTCYAN, WHITE, GREEN, MAGENTA };
+const int ARENA_COLOR_COUNT = sizeof(ARENA_COLORS) / sizeof(ARENA_COLORS[0]);
+
+// Gap of unchanged cells that is cheaper to rewrite than to jump over with a cursor move
+const int MAX_REWRITE_GAP = 6;
+
+void ResetRenderer(Renderer* renderer) {
+    renderer->frontValid = false;
+    renderer->out.reserve(MAX_PRESENT_BYTES);
+}
+
+void ClearFrame(Frame* frame) {
+    for (int y = 0; y < SCREEN_HEIGHT; y++) {
+        for (int x = 0; x < SCREEN_WIDTH; x++) {
+            frame->cells[y][x].ch = EMPTY;
+            frame->cells[y][x].color = (BLACK << 4) | WHITE;
+        }
+    }
+}
+
+void PutText(Frame* frame, int x, int y, const char* text, int textColor, int bgColor) {
+    if (y < 0 || y >= SCREEN_HEIGHT) return;
+    unsigned char color = static_cast<unsigned char>((bgColor << 4) | textColor);
+    for (; *text != '\0' && x < SCREEN_WIDTH; text++, x++) {
+        if (x < 0) continue;
+        frame->cells[y][x].ch = *text;
+        frame->cells[y][x].color = color;
+    }
+}
+
+void PutCentered(Frame* frame, int y, const char* text, int textColor, int bgColor) {
+    int x = (SCREEN_WIDTH - static_cast<int>(strlen(text))) / 2;
+    PutText(frame, x, y, text, textColor, bgColor);
+}
+
+void PutCentered(Frame* frame, int y, const string& text, int textColor, int bgColor) {
+    PutCentered(frame, y, text.c_str(), textColor, bgColor);
+}
+
+// Draw a box with borders
+void DrawBox(Frame* frame, int x, int y, int width, int height, int textColor) {
+    string edge(width, WALL_HORIZONTAL);
+
+    // Draw top border
+    edge.front() = WALL_CORNER_TL;
+    edge.back() = WALL_CORNER_TR;
+    PutText(frame, x, y, edge.c_str(), textColor);
+
+    // Draw side borders
+    const char side[2] = { WALL_VERTICAL, '\0' };
+    for (int i = 1; i < height - 1; i++) {
+        PutText(frame, x, y + i, side, textColor);
+        PutText(frame, x + width - 1, y + i, side, textColor);
+    }
+
+    // Draw bottom border
+    edge.front() = WALL_CORNER_BL;
+    edge.back() = WALL_CORNER_BR;
+    PutText(frame, x, y + height - 1, edge.c_str(), textColor);
+}
+
+// Put one board cell; cells are two columns wide for a better aspect ratio
+static void PutBoardCell(Frame* frame, int x, int y, char ch, int textColor) {
+    if (y < 0 || y >= SCREEN_HEIGHT) return;
+    unsigned char color = static_cast<unsigned char>((BLACK << 4) | textColor);
+    for (int i = 0; i < 2; i++) {
+        if (x + i < 0 || x + i >= SCREEN_WIDTH) continue;
+        frame->cells[y][x + i].ch = (i == 0) ? ch : EMPTY;
+        frame->cells[y][x + i].color = color;
+    }
+}
+
+// First board cell shown so that focus sits mid-view without scrolling past the walls
+static int ScrollOrigin(int focus, int view, int size) {
+    return max(0, min(focus - view / 2, size - view));
+}
+
+// Glyph of a border cell of a board whose last column and row are right and bottom
+static char WallGlyph(int x, int y, int right, int bottom) {
+    if (y == 0 || y == bottom) {
+        return (x == 0) ? (y == 0 ? WALL_CORNER_TL : WALL_CORNER_BL)
+            : (x == right) ? (y == 0 ? WALL_CORNER_TR : WALL_CORNER_BR)
+            : WALL_HORIZONTAL;
+    }
+    return WALL_VERTICAL;
+}
+
+void DrawBoard(const GameState& game, Frame* frame, int offsetX, int offsetY, int viewWidth, int viewHeight) {
+    viewWidth = min(viewWidth, game.width);
+    viewHeight = min(viewHeight, game.height);
+    int originX = ScrollOrigin(game.snake[0].x, viewWidth, game.width);
+    int originY = ScrollOrigin(game.snake[0].y, viewHeight, game.height);
+    int right = game.width - 1;
+    int bottom = game.height - 1;
+
+    // Only the visible cells are looked at, so the cost depends on the view, not the board
+    for (int vy = 0; vy < viewHeight; vy++) {
+        int y = originY + vy;
+        for (int vx = 0; vx < viewWidth; vx++) {
+            int x = originX + vx;
+            int screenX = offsetX + vx * 2;
+            int screenY = offsetY + vy;
+
+            if (x == 0 || y == 0 || x == right || y == bottom) {
+                PutBoardCell(frame, screenX, screenY, WallGlyph(x, y, right, bottom), CYAN);
+            }
+            else if (x == game.snake[0].x && y == game.snake[0].y) {
+                PutBoardCell(frame, screenX, screenY, SNAKE_HEAD, LIGHTGREEN);
+            }
+            else if (IsOccupied(game, x, y)) {
+                PutBoardCell(frame, screenX, screenY, SNAKE_BODY, GREEN);
+            }
+            else if (x == game.foodX && y == game.foodY) {
+                PutBoardCell(frame, screenX, screenY, FOOD, LIGHTRED);
+            }
+            else {
+                PutBoardCell(frame, screenX, screenY, EMPTY, WHITE);
+            }
+        }
+    }
+}
+
+void DrawBoardWalls(Frame* frame, int offsetX, int offsetY, int width, int height) {
+    int right = width - 1;
+    int bottom = height - 1;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            bool wall = (x == 0 || y == 0 || x == right || y == bottom);
+            PutBoardCell(frame, offsetX + x * 2, offsetY + y, wall ? WallGlyph(x, y, right, bottom) : EMPTY, wall ? CYAN : WHITE);
+        }
+    }
+}
+
+void DrawBoardItems(const GameState& game, Frame* frame, int offsetX, int offsetY) {
+    PutBoardCell(frame, offsetX + game.foodX * 2, offsetY + game.foodY, FOOD, LIGHTRED);
+
+    // Tail first so the head wins where they meet after a collision; a head
+    // that ran into a wall leaves the wall showing, as in DrawBoard()
+    for (size_t i = game.snake.size(); i-- > 0;) {
+        const SnakeSegment& segment = game.snake[i];
+        if (segment.x <= 0 || segment.y <= 0 || segment.x >= game.width - 1 || segment.y >= game.height - 1) continue;
+        if (i == 0) PutBoardCell(frame, offsetX + segment.x * 2, offsetY + segment.y, SNAKE_HEAD, LIGHTGREEN);
+        else PutBoardCell(frame, offsetX + segment.x * 2, offsetY + segment.y, SNAKE_BODY, GREEN);
+    }
+}
+
+bool BoardFitsView(const GameState& game, int viewWidth, int viewHeight) {
+    return game.width <= viewWidth && game.height <= viewHeight;
+}
+
+void DrawArena(const Arena& arena, Frame* frame, int offsetX, int offsetY, int viewWidth, int viewHeight, int focus) {
+    viewWidth = min(viewWidth, arena.width);
+    viewHeight = min(viewHeight, arena.height);
+    int focusX = arena.width / 2;
+    int focusY = arena.height / 2;
+    if (focus >= 0 && focus < static_cast<int>(arena.snakes.size()) && arena.snakes[focus].alive) {
+        focusX = arena.snakes[focus].body[0].x;
+        focusY = arena.snakes[focus].body[0].y;
+    }
+    int originX = ScrollOrigin(focusX, viewWidth, arena.width);
+    int originY = ScrollOrigin(focusY, viewHeight, arena.height);
+    int right = arena.width - 1;
+    int bottom = arena.height - 1;
+
+    for (int vy = 0; vy < viewHeight; vy++) {
+        int y = originY + vy;
+        for (int vx = 0; vx < viewWidth; vx++) {
+            int x = originX + vx;
+            int screenX = offsetX + vx * 2;
+            int screenY = offsetY + vy;
+            int owner = arena.owner[y * arena.width + x];
+
+            if (x == 0 || y == 0 || x == right || y == bottom) {
+                PutBoardCell(frame, screenX, screenY, WallGlyph(x, y, right, bottom), CYAN);
+            }
+            else if (owner != NO_SNAKE) {
+                const SnakeSegment& head = arena.snakes[owner].body[0];
+                bool isHead = (head.x == x && head.y == y);
+                PutBoardCell(frame, screenX, screenY, isHead ? SNAKE_HEAD : SNAKE_BODY, ARENA_COLORS[owner % ARENA_COLOR_COUNT]);
+            }
+            else if (IsArenaFood(arena, x, y)) {
+                PutBoardCell(frame, screenX, screenY, FOOD, LIGHTRED);
+            }
+            else {
+                PutBoardCell(frame, screenX, screenY, EMPTY, WHITE);
+            }
+        }
+    }
+}
+
+int ArenaColor(int index) {
+    return ARENA_COLORS[index % ARENA_COLOR_COUNT];
+}
+
+// Append an SGR sequence for a console color attribute. Console colors store
+// blue in bit 0 and red in bit 2; ANSI colors are the other way round.
+static void AppendColor(string* out, unsigned char color) {
+    static const int ansi[8] = { 0, 4, 2, 6, 1, 5, 3, 7 };
+    int fg = color & 0x0F;
+    int bg = (color >> 4) & 0x0F;
+    char buf[24];
+    int n = snprintf(buf, sizeof(buf), "\x1b[%d;%dm",
+        (fg & 8 ? 90 : 30) + ansi[fg & 7], (bg & 8 ? 100 : 40) + ansi[bg & 7]);
+    out->append(buf, n);
+}
+
+static void AppendMove(string* out, int x, int y) {
+    char buf[16];
+    int n = snprintf(buf, sizeof(buf), "\x1b[%d;%dH", y + 1, x + 1);
+    out->append(buf, n);
+}
+
+static bool SameCell(const Cell& a, const Cell& b) {
+    return a.ch == b.ch && a.color == b.color;
+}
+
+// UTF-8 for the code page 437 box-drawing glyphs the walls use, or nullptr
+static const char* Utf8Glyph(char ch) {
+    switch (ch) {
+    case WALL_HORIZONTAL:
+        return "\xE2\x95\x90"; // ═
+    case WALL_VERTICAL:
+        return "\xE2\x95\x91"; // ║
+    case WALL_CORNER_TL:
+        return "\xE2\x95\x94"; // ╔
+    case WALL_CORNER_TR:
+        return "\xE2\x95\x97"; // ╗
+    case WALL_CORNER_BL:
+        return "\xE2\x95\x9A"; // ╚
+    case WALL_CORNER_BR:
+        return "\xE2\x95\x9D"; // ╝
+    default:
+        return nullptr;
+    }
+}
+
+size_t Present(Renderer* renderer) {
+    string& out = renderer->out;
+    out.clear();
+
+    const Frame& back = renderer->back;
+    const Frame& front = renderer->front;
+    bool full = !renderer->frontValid;
+    if (full) out.append("\x1b[2J");
+
+    int cursorX = -1, cursorY = -1; // unknown until the first move
+    int color = -1;
+    for (int y = 0; y < SCREEN_HEIGHT; y++) {
+        const Cell* row = back.cells[y];
+        const Cell* shown = front.cells[y];
+        int x = 0;
+        while (x < SCREEN_WIDTH) {
+            if (!full && SameCell(row[x], shown[x])) {
+                x++;
+                continue;
+            }
+
+            // Extend the run over changed cells and over short unchanged gaps
+            int end = x + 1;
+            int gap = 0;
+            for (int i = end; i < SCREEN_WIDTH; i++) {
+                if (full || !SameCell(row[i], shown[i])) {
+                    end = i + 1;
+                    gap = 0;
+                }
+                else if (++gap > MAX_REWRITE_GAP) {
+                    break;
+                }
+            }
+
+            if (cursorX != x || cursorY != y) AppendMove(&out, x, y);
+            for (int i = x; i < end; i++) {
+                if (row[i].color != color) {
+                    color = row[i].color;
+                    AppendColor(&out, row[i].color);
+                }
+                const char* glyph = renderer->utf8 ? Utf8Glyph(row[i].ch) : nullptr;
+                if (glyph != nullptr) out.append(glyph);
+                else out.push_back(row[i].ch);
+            }
+            cursorX = end;
+            cursorY = y;
+            x = end;
+        }
+    }
+
+    CommitFrame(renderer);
+    return out.size();
+}
+
+bool ChangedRegion(const Renderer& renderer, int* left, int* top, int* right, int* bottom) {
+    if (!renderer.frontValid) {
+        *left = 0;
+        *top = 0;
+        *right = SCREEN_WIDTH - 1;
+        *bottom = SCREEN_HEIGHT - 1;
+        return true;
+    }
+
+    *left = SCREEN_WIDTH;
+    *top = SCREEN_HEIGHT;
+    *right = -1;
+    *bottom = -1;
+    for (int y = 0; y < SCREEN_HEIGHT; y++) {
+        const Cell* row = renderer.back.cells[y];
+        const Cell* shown = renderer.front.cells[y];
+        for (int x = 0; x < SCREEN_WIDTH; x++) {
+            if (SameCell(row[x], shown[x])) continue;
+            *left = min(*left, x);
+            *right = max(*right, x);
+            *top = min(*top, y);
+            *bottom = y;
+        }
+    }
+    return *right >= 0;
+}
+
+void CommitFrame(Renderer* renderer) {
+    memcpy(&renderer->front, &renderer->back, sizeof(Frame));
+    renderer->frontValid = true;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <string>
+#include "Engine.h"
+
+struct Arena;
+
+// Console color codes
+enum Color {
+    BLACK = 0,
+    BLUE = 1,
+    GREEN = 2,
+    CYAN = 3,
+    RED = 4,
+    MAGENTA = 5,
+    BROWN = 6,
+    LIGHTGRAY = 7,
+    DARKGRAY = 8,
+    LIGHTBLUE = 9,
+    LIGHTGREEN = 10,
+    LIGHTCYAN = 11,
+    LIGHTRED = 12,
+    LIGHTMAGENTA = 13,
+    YELLOW = 14,
+    WHITE = 15
+};
+
+// Board glyphs (box drawing characters are code page 437, the console default)
+const char SNAKE_BODY = 'O';
+const char SNAKE_HEAD = '@';
+const char FOOD = '*';
+const char EMPTY = ' ';
+const char WALL_HORIZONTAL = '\xCD'; // ═
+const char WALL_VERTICAL = '\xBA'; // ║
+const char WALL_CORNER_TL = '\xC9'; // ╔
+const char WALL_CORNER_TR = '\xBB'; // ╗
+const char WALL_CORNER_BL = '\xC8'; // ╚
+const char WALL_CORNER_BR = '\xBC'; // ╝
+
+// Console size set by main()
+const int SCREEN_WIDTH = 80;
+const int SCREEN_HEIGHT = 25;
+
+// One character cell of the console
+struct Cell {
+    char ch;
+    unsigned char color; // (background << 4) | text, as SetConsoleColor uses
+};
+
+// A full screen of cells
+struct Frame {
+    Cell cells[SCREEN_HEIGHT][SCREEN_WIDTH];
+};
+
+// Double-buffered renderer: the front frame is what the console shows,
+// the back frame is built by the caller and then diffed against it.
+struct Renderer {
+    Frame front;
+    Frame back;
+    bool frontValid; // false until a full frame has been written
+    bool utf8 = false; // Present() writes box-drawing glyphs as UTF-8 instead of code page 437
+    std::string out; // escape-encoded output of the last Present(), reused between frames
+};
+
+// Largest output Present() can produce: every cell with its own color change and
+// a three-byte glyph, plus a cursor move per row. ResetRenderer() reserves it so
+// building a frame never allocates.
+const size_t MAX_PRESENT_BYTES = SCREEN_WIDTH * SCREEN_HEIGHT * 24 + SCREEN_HEIGHT * 16 + 16;
+
+// Forget what is on screen so the next Present() repaints everything
+void ResetRenderer(Renderer* renderer);
+
+// Fill a frame with blanks
+void ClearFrame(Frame* frame);
+
+// Write text into a frame, clipping at the screen edges
+void PutText(Frame* frame, int x, int y, const char* text, int textColor, int bgColor = BLACK);
+
+// Write text centered on a screen row
+void PutCentered(Frame* frame, int y, const char* text, int textColor, int bgColor = BLACK);
+void PutCentered(Frame* frame, int y, const std::string& text, int textColor, int bgColor = BLACK);
+
+// Draw a box with double-line borders, its top-left corner at (x, y)
+void DrawBox(Frame* frame, int x, int y, int width, int height, int textColor);
+
+// Draw the walls, food and snake into a view of viewWidth x viewHeight board cells
+// whose top-left corner is at (offsetX, offsetY). Board cells are two columns wide.
+// Boards larger than the view are cropped, scrolling to keep the head in view.
+void DrawBoard(const GameState& game, Frame* frame, int offsetX, int offsetY, int viewWidth, int viewHeight);
+
+// Draw the walls of a width x height board that fits its view, with every cell
+// inside left blank, for a background layer built once and copied in each frame
+void DrawBoardWalls(Frame* frame, int offsetX, int offsetY, int width, int height);
+
+// Draw the food and snake over a layer from DrawBoardWalls(). Only the cells that
+// hold something are touched, so the cost follows the snake's length rather than
+// the board's size. The frame matches what DrawBoard() would give.
+void DrawBoardItems(const GameState& game, Frame* frame, int offsetX, int offsetY);
+
+// Whether DrawBoardWalls() and DrawBoardItems() can draw the board, which they
+// can when it is shown whole instead of scrolling
+bool BoardFitsView(const GameState& game, int viewWidth, int viewHeight);
+
+// Draw a multi-snake arena the same way, each snake in its own color. The view
+// follows the head of snake focus, or shows the middle of the board if it is dead.
+void DrawArena(const Arena& arena, Frame* frame, int offsetX, int offsetY, int viewWidth, int viewHeight, int focus);
+
+// Color DrawArena() gives a snake
+int ArenaColor(int index);
+
+// Encode the cells that differ between the back and front frames into renderer->out
+// as VT escape sequences, then make the back frame the new front. Unchanged cells
+// are skipped, and color changes are only emitted between runs of different colors.
+// Returns the number of bytes to write.
+size_t Present(Renderer* renderer);
+
+// Smallest rectangle holding every cell that differs between the back and front
+// frames, or the whole screen before the first frame. Returns false if nothing changed.
+bool ChangedRegion(const Renderer& renderer, int* left, int* top, int* right, int* bottom);
+
+// Record that the back frame is now on screen, for backends that write cells
+// themselves instead of using Present()
+void CommitFrame(Renderer* renderer);
@@ -0,0 +1,130 @@
+#include "Replay.h"
+
+#include <cstdio>
+#include <cstring>
+#include "Varint.h"
+
+using namespace std;
+
+const char REPLAY_MAGIC[4] = { 'S', 'N', 'K', 'R' };
+const uint8_t REPLAY_VERSION = 2; // 2: 64-bit seeds and xoshiro256** food placement
+
+void StartRecording(Replay* replay, const GameConfig& config) {
+    replay->config = config;
+    replay->ticks = 0;
+    replay->events.clear();
+    replay->events.reserve(REPLAY_RESERVED_EVENTS);
+    replay->finalScore = 0;
+    replay->finalLength = 0;
+}
+
+void RecordTurn(Replay* replay, const GameState& game, Direction dir) {
+    if (dir == STOP) return;
+    replay->events.push_back(ReplayEvent{ game.tick, dir });
+}
+
+void FinishRecording(Replay* replay, const GameState& game) {
+    replay->ticks = game.tick;
+    replay->finalScore = game.score;
+    replay->finalLength = static_cast<uint32_t>(game.snake.size());
+}
+
+void EncodeReplay(const Replay& replay, vector<uint8_t>* out) {
+    out->assign(REPLAY_MAGIC, REPLAY_MAGIC + sizeof(REPLAY_MAGIC));
+    out->push_back(REPLAY_VERSION);
+    PutVarint(out, replay.config.seed);
+    PutVarint(out, replay.config.width);
+    PutVarint(out, replay.config.height);
+    PutVarint(out, replay.ticks);
+    PutVarint(out, static_cast<uint64_t>(replay.finalScore));
+    PutVarint(out, replay.finalLength);
+    PutVarint(out, replay.events.size());
+
+    // Direction in the low two bits, ticks since the previous turn above them
+    uint32_t lastTick = 0;
+    for (const ReplayEvent& event : replay.events) {
+        PutVarint(out, (uint64_t(event.tick - lastTick) << 2) | (event.dir - LEFT));
+        lastTick = event.tick;
+    }
+}
+
+bool DecodeReplay(const uint8_t* data, size_t size, Replay* replay) {
+    const uint8_t* end = data + size;
+    if (size < sizeof(REPLAY_MAGIC) + 1 || memcmp(data, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0 ||
+        data[sizeof(REPLAY_MAGIC)] != REPLAY_VERSION) {
+        return false;
+    }
+    data += sizeof(REPLAY_MAGIC) + 1;
+
+    uint64_t seed, width, height, ticks, score, length, count;
+    if (!GetVarint(&data, end, &seed) || !GetVarint(&data, end, &width) ||
+        !GetVarint(&data, end, &height) || !GetVarint(&data, end, &ticks) ||
+        !GetVarint(&data, end, &score) || !GetVarint(&data, end, &length) ||
+        !GetVarint(&data, end, &count) || count > size) {
+        return false;
+    }
+    replay->config.seed = seed;
+    replay->config.width = static_cast<int>(width);
+    replay->config.height = static_cast<int>(height);
+    replay->ticks = static_cast<uint32_t>(ticks);
+    replay->finalScore = static_cast<int>(score);
+    replay->finalLength = static_cast<uint32_t>(length);
+
+    replay->events.clear();
+    replay->events.reserve(count);
+    uint32_t tick = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t packed;
+        if (!GetVarint(&data, end, &packed)) return false;
+        tick += static_cast<uint32_t>(packed >> 2);
+        replay->events.push_back(ReplayEvent{ tick, static_cast<Direction>(LEFT + (packed & 3)) });
+    }
+    return data == end;
+}
+
+bool SaveReplay(const Replay& replay, const string& path) {
+    vector<uint8_t> bytes;
+    EncodeReplay(replay, &bytes);
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    return (fclose(file) == 0) && ok;
+}
+
+bool LoadReplay(Replay* replay, const string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+
+    vector<uint8_t> bytes;
+    uint8_t buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        bytes.insert(bytes.end(), buffer, buffer + n);
+    }
+    fclose(file);
+    return DecodeReplay(bytes.data(), bytes.size(), replay);
+}
+
+void StartPlayback(const Replay& replay, GameState* game, ReplayCursor* cursor) {
+    Setup(game, replay.config);
+    cursor->nextEvent = 0;
+}
+
+bool StepPlayback(const Replay& replay, GameState* game, ReplayCursor* cursor) {
+    if (game->gameOver || game->tick >= replay.ticks) return false;
+
+    while (cursor->nextEvent < replay.events.size() && replay.events[cursor->nextEvent].tick == game->tick) {
+        QueueTurn(game, replay.events[cursor->nextEvent].dir);
+        cursor->nextEvent++;
+    }
+    Logic(game);
+    return true;
+}
+
+bool PlayReplay(const Replay& replay, GameState* game) {
+    ReplayCursor cursor;
+    StartPlayback(replay, game, &cursor);
+    while (StepPlayback(replay, game, &cursor)) {}
+    return game->score == replay.finalScore && game->snake.size() == replay.finalLength;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Engine.h"
+
+// A turn fed to QueueTurn() before the given tick's Logic()
+struct ReplayEvent {
+    uint32_t tick;
+    Direction dir;
+};
+
+// Everything needed to reproduce a game: its config (board and seed) and the
+// turns in tick order. The final score and length are kept so playback can
+// check that the engine still produces the same game.
+struct Replay {
+    GameConfig config;
+    uint32_t ticks;
+    std::vector<ReplayEvent> events;
+    int finalScore;
+    uint32_t finalLength;
+};
+
+// Position of a playback in its replay
+struct ReplayCursor {
+    size_t nextEvent;
+};
+
+// Turns StartRecording() makes room for, so recording a game of up to this
+// many turns never allocates while it runs
+const size_t REPLAY_RESERVED_EVENTS = 1 << 16;
+
+// Begin recording a game set up with config
+void StartRecording(Replay* replay, const GameConfig& config);
+
+// Record a turn QueueTurn() accepted during the current tick. Rejected turns
+// have no effect on the game and need not be recorded.
+void RecordTurn(Replay* replay, const GameState& game, Direction dir);
+
+// Record how the game ended
+void FinishRecording(Replay* replay, const GameState& game);
+
+// Compact binary form: a header of varints, then one varint per turn holding the
+// ticks since the previous turn and the direction, so idle stretches cost nothing
+// and a turn usually takes one or two bytes
+void EncodeReplay(const Replay& replay, std::vector<uint8_t>* out);
+bool DecodeReplay(const uint8_t* data, size_t size, Replay* replay);
+
+bool SaveReplay(const Replay& replay, const std::string& path);
+bool LoadReplay(Replay* replay, const std::string& path);
+
+// Set up a game for playback from the start of the replay
+void StartPlayback(const Replay& replay, GameState* game, ReplayCursor* cursor);
+
+// Run one recorded tick; returns false once the replay or the game has ended
+bool StepPlayback(const Replay& replay, GameState* game, ReplayCursor* cursor);
+
+// Play a whole replay headless; returns true if it ended with the recorded score and length
+bool PlayReplay(const Replay& replay, GameState* game);
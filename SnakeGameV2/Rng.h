@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+
+// xoshiro256** random source. A game owns one, so games on different threads
+// never share state, and the same seed always gives the same numbers on every
+// platform. Seeds are spread over the 256-bit state with SplitMix64, so nearby
+// seeds such as seed + i still give unrelated streams.
+class Rng {
+public:
+    typedef uint64_t result_type;
+
+    Rng() { Seed(0); }
+    explicit Rng(uint64_t seed) { Seed(seed); }
+
+    void Seed(uint64_t seed) {
+        for (uint64_t& word : state) {
+            seed += 0x9E3779B97F4A7C15ull;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t Next() {
+        uint64_t result = Rotate(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = Rotate(state[3], 45);
+        return result;
+    }
+
+    // Uniform in [0, bound) without modulo bias: the high half of a 32x32-bit
+    // product, redrawn only in the rare case the low half lands in the biased
+    // sliver (Lemire's method). bound must be non-zero.
+    uint32_t Below(uint32_t bound) {
+        uint64_t product = (Next() >> 32) * bound;
+        uint32_t low = static_cast<uint32_t>(product);
+        if (low < bound) {
+            uint32_t threshold = (0u - bound) % bound;
+            while (low < threshold) {
+                product = (Next() >> 32) * bound;
+                low = static_cast<uint32_t>(product);
+            }
+        }
+        return static_cast<uint32_t>(product >> 32);
+    }
+
+    // Advance by 2^128 numbers. Jumping a copy k times gives stream k, which
+    // cannot overlap any other stream within 2^128 draws.
+    void Jump() {
+        static const uint64_t JUMP[4] = {
+            0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull, 0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull
+        };
+        uint64_t jumped[4] = { 0, 0, 0, 0 };
+        for (uint64_t mask : JUMP) {
+            for (int bit = 0; bit < 64; bit++) {
+                if (mask & (uint64_t(1) << bit)) {
+                    for (int i = 0; i < 4; i++) jumped[i] ^= state[i];
+                }
+                Next();
+            }
+        }
+        for (int i = 0; i < 4; i++) state[i] = jumped[i];
+    }
+
+    // A new generator seeded from this one; cheaper than Jump() for handing a
+    // child task its own stream
+    Rng Split() { return Rng(Next()); }
+
+    // The raw 256-bit state, for saving a game and picking it up where it left off
+    void GetState(uint64_t out[4]) const {
+        for (int i = 0; i < 4; i++) out[i] = state[i];
+    }
+
+    void SetState(const uint64_t in[4]) {
+        for (int i = 0; i < 4; i++) state[i] = in[i];
+    }
+
+    // Standard uniform random bit generator interface, for <algorithm> and <random>
+    static constexpr uint64_t min() { return 0; }
+    static constexpr uint64_t max() { return ~uint64_t(0); }
+    uint64_t operator()() { return Next(); }
+
+private:
+    static uint64_t Rotate(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    uint64_t state[4];
+};
@@ -0,0 +1,128 @@
+#include "Screens.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include "UserStore.h"
+
+using namespace std;
+
+// Row of the leaderboard box; the entries are filled in below its headings
+const int LEADERBOARD_BOX_Y = 5;
+
+const char* const GAME_CONTROLS = "Controls: W (Up), A (Left), S (Down), D (Right), P (Stats), X (Save)";
+
+BoardView GameBoardView(const GameState& game) {
+    BoardView view;
+    view.y = 3;
+    view.width = min(game.width, SCREEN_WIDTH / 2);
+    view.height = min(game.height, SCREEN_HEIGHT - view.y - 2);
+    view.x = (SCREEN_WIDTH - view.width * 2) / 2;
+    return view;
+}
+
+void BuildGameLayer(const GameState& game, GameLayer* layer) {
+    Frame* frame = &layer->frame;
+    ClearFrame(frame);
+    PutCentered(frame, 0, "SNAKE GAME", YELLOW);
+
+    BoardView view = GameBoardView(game);
+    if (BoardFitsView(game, view.width, view.height)) DrawBoardWalls(frame, view.x, view.y, game.width, game.height);
+    PutCentered(frame, view.y + view.height + 1, GAME_CONTROLS, WHITE);
+
+    layer->width = game.width;
+    layer->height = game.height;
+}
+
+void FormatPlayerLine(const GameState& game, char* line, size_t size) {
+    if (game.currentUser) {
+        snprintf(line, size, "Player: %s | Score: %d | High Score: %d",
+            game.currentUser->username.c_str(), game.score, game.currentUser->highScore);
+    }
+    else {
+        snprintf(line, size, "Player: Guest | Score: %d", game.score);
+    }
+}
+
+void FormatProfileHud(const Profiler& profiler, char* line, size_t size) {
+    uint64_t frames = min<uint64_t>(profiler.traceCount, 64);
+    uint64_t ns = 0;
+    uint64_t ticks = 0;
+    uint64_t bytes = 0;
+    for (uint64_t i = profiler.traceCount - frames; i < profiler.traceCount; i++) {
+        const FrameSample& sample = profiler.trace[i % TRACE_FRAMES];
+        ns += sample.frameNs;
+        ticks += sample.ticksRun;
+        bytes += sample.bytes;
+    }
+
+    snprintf(line, size, "frame p50 %.1fms p99 %.1fms | draw p99 %.0fus | %.0f B/frame | %.1f ticks/s",
+        Percentile(profiler.metrics[METRIC_FRAME], 0.50) / 1e6, Percentile(profiler.metrics[METRIC_FRAME], 0.99) / 1e6,
+        Percentile(profiler.metrics[METRIC_DRAW], 0.99) / 1e3, frames > 0 ? double(bytes) / frames : 0.0,
+        ns > 0 ? ticks * 1e9 / ns : 0.0);
+}
+
+void ComposeGameFrame(const GameState& game, GameLayer* layer, const Profiler* hud, Frame* frame) {
+    // Start from the title, walls and controls line composed for this board size
+    if (layer->width != game.width || layer->height != game.height) BuildGameLayer(game, layer);
+    *frame = layer->frame;
+
+    char line[SCREEN_WIDTH + 1];
+    FormatPlayerLine(game, line, sizeof(line));
+    PutCentered(frame, 1, line, CYAN);
+    if (hud != nullptr) {
+        FormatProfileHud(*hud, line, sizeof(line));
+        PutCentered(frame, 2, line, LIGHTGRAY);
+    }
+
+    // Inside the cached walls only the food and snake need drawing; a board
+    // that scrolls has its walls move, so it is drawn whole
+    BoardView view = GameBoardView(game);
+    if (BoardFitsView(game, view.width, view.height)) DrawBoardItems(game, frame, view.x, view.y);
+    else DrawBoard(game, frame, view.x, view.y, view.width, view.height);
+}
+
+size_t DrawGame(const GameState& game, GameLayer* layer, const Profiler* hud, Renderer* renderer, Console* console) {
+    ComposeGameFrame(game, layer, hud, &renderer->back);
+
+    // Write only the cells that changed since the last frame, in one call
+    return console->Show(renderer);
+}
+
+void BuildLeaderboardLayer(Frame* frame) {
+    ClearFrame(frame);
+
+    int y = LEADERBOARD_BOX_Y;
+    PutText(frame, 32, y - 2, "LEADERBOARD", YELLOW);
+
+    // Draw leaderboard box
+    DrawBox(frame, 20, y, 40, 15, CYAN);
+
+    // Draw header and separator
+    char line[64];
+    snprintf(line, sizeof(line), "%-5s%-20s%s", "Rank", "Username", "High Score");
+    PutText(frame, 22, y + 1, line, LIGHTGREEN);
+    PutText(frame, 22, y + 2, string(36, '-').c_str(), WHITE);
+
+    // Footer
+    PutText(frame, 25, y + 13, "Press any key to return...", WHITE);
+}
+
+void ComposeLeaderboard(const Leaderboard& leaderboard, const Frame& layer, Frame* frame) {
+    *frame = layer;
+    int y = LEADERBOARD_BOX_Y;
+
+    // Top users straight from the ranking, without copying or sorting
+    const User* topUsers[10];
+    size_t count = leaderboard.Top(10, topUsers);
+
+    // Draw entries, highlighting the top 3
+    char line[64];
+    for (size_t i = 0; i < count; i++) {
+        snprintf(line, sizeof(line), "%-5zu%-20s%d", i + 1, topUsers[i]->username.c_str(), topUsers[i]->highScore);
+        PutText(frame, 22, y + 3 + static_cast<int>(i), line, i < 3 ? YELLOW : WHITE);
+    }
+
+    // If no users yet
+    if (count == 0) PutText(frame, 28, y + 7, "No records yet!", LIGHTGRAY);
+}
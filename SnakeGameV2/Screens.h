@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include "Console.h"
+#include "Engine.h"
+#include "Leaderboard.h"
+#include "Profiler.h"
+#include "Renderer.h"
+
+// The game screen as the console front end shows it, built here so the
+// benchmarks and the allocation check run the same code the game does
+
+// Where the game board sits on screen: the view's top-left corner and its size in board cells
+struct BoardView {
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+// Show as much of the board as fits between the header and the controls line,
+// centered; larger boards scroll with the snake
+BoardView GameBoardView(const GameState& game);
+
+// The parts of the game screen that stay put for a board size: the title, the
+// controls line and, when the whole board fits, its walls. They are composed
+// once per board size and copied into each frame.
+struct GameLayer {
+    Frame frame;
+    int width = 0; // board size the layer was built for; 0 before the first build
+    int height = 0;
+};
+
+void BuildGameLayer(const GameState& game, GameLayer* layer);
+
+// "Player: name | Score: n | High Score: n", or the guest's score, formatted
+// in place so a frame never allocates
+void FormatPlayerLine(const GameState& game, char* line, size_t size);
+
+// One line of live performance figures: frame time percentiles, the slowest draws,
+// and the tick rate and bytes per frame over the most recent frames
+void FormatProfileHud(const Profiler& profiler, char* line, size_t size);
+
+// Build the game screen in frame: the cached layer, rebuilt if the board size
+// changed, the player line, the profiler's figures when hud is set, and the
+// food and snake
+void ComposeGameFrame(const GameState& game, GameLayer* layer, const Profiler* hud, Frame* frame);
+
+// Compose the game screen in the renderer's back frame and show it; returns
+// the bytes written to the console
+size_t DrawGame(const GameState& game, GameLayer* layer, const Profiler* hud, Renderer* renderer, Console* console);
+
+// Leaderboard screen: the title, the box, the column headings and the footer,
+// built once and copied in on each visit
+void BuildLeaderboardLayer(Frame* frame);
+
+// Build the leaderboard screen in frame: the layer with the top ten over it,
+// ranked by their place in the list
+void ComposeLeaderboard(const Leaderboard& leaderboard, const Frame& layer, Frame* frame);
@@ -0,0 +1,945 @@
+// Headless benchmark: plays seeded games without a console and reports ticks per second
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Autopilot.h"
+#include "BatchEnv.h"
+#include "Console.h"
+#include "Engine.h"
+#include "GameLoop.h"
+#include "InputQueue.h"
+#include "Leaderboard.h"
+#include "Profiler.h"
+#include "Renderer.h"
+#include "Replay.h"
+#include "Screens.h"
+#include "Snapshot.h"
+#include "TickTimer.h"
+#include "UserDirectory.h"
+#include "UserStore.h"
+
+using namespace std;
+
+// Every heap allocation the benchmark makes, on any thread, for the allocation check
+static atomic<long long> heapAllocations(0);
+
+void* operator new(size_t size) {
+    heapAllocations.fetch_add(1, memory_order_relaxed);
+    void* block = malloc(size > 0 ? size : 1);
+    if (block == nullptr) throw bad_alloc();
+    return block;
+}
+
+void operator delete(void* block) noexcept {
+    free(block);
+}
+
+void operator delete(void* block, size_t) noexcept {
+    free(block);
+}
+
+// Steer towards the food, preferring the axis with the larger distance
+Direction ChaseFood(const GameState& game) {
+    const SnakeSegment& head = game.snake[0];
+    int dx = game.foodX - head.x;
+    int dy = game.foodY - head.y;
+    if (abs(dx) >= abs(dy) && dx != 0) return dx < 0 ? LEFT : RIGHT;
+    if (dy != 0) return dy < 0 ? UP : DOWN;
+    return dx < 0 ? LEFT : RIGHT;
+}
+
+// Run ticks on the fixed-timestep timer and report how late they fire
+int RunTimerBench(int ticks, int periodMs) {
+    GameState game;
+    game.currentUser = nullptr;
+    Setup(&game, GameConfig());
+
+    TickTimer timer;
+    StartTimer(&timer, periodMs);
+    while (timer.ticks < ticks) {
+        WaitForTick(&timer);
+        int due = DueTicks(&timer);
+        for (int i = 0; i < due; i++) {
+            if (game.gameOver) Setup(&game, GameConfig());
+            Direction input = ChaseFood(game);
+            Simulate(&game, &input, 1);
+        }
+    }
+
+    printf("period_ms=%d ticks=%lld dropped=%lld jitter_mean_us=%.1f jitter_stddev_us=%.1f jitter_max_us=%.1f\n",
+        periodMs, timer.ticks, timer.droppedTicks, MeanJitterUs(timer), JitterStdDevUs(timer), timer.jitterMaxUs);
+    return 0;
+}
+
+// Feed key presses from a producer thread through the input queue into a
+// fixed-timestep consumer and report the press-to-tick latency
+int RunInputBench(int events, int periodMs) {
+    InputQueue queue;
+    InputLatency latency = { 0, 0, 0 };
+    atomic<bool> done(false);
+
+    thread producer([&]() {
+        Rng rng(7);
+        const int keys[4] = { 'w', 'd', 's', 'a' };
+        for (int i = 0; i < events; i++) {
+            this_thread::sleep_for(chrono::microseconds(rng.Below(periodMs * 2000)));
+            InputEvent event;
+            event.key = keys[i % 4];
+            event.time = chrono::steady_clock::now();
+            while (!queue.Push(event)) this_thread::yield();
+        }
+        done = true;
+    });
+
+    GameState game;
+    game.currentUser = nullptr;
+    Setup(&game, GameConfig());
+    TickTimer timer;
+    StartTimer(&timer, periodMs);
+    while (!done || latency.count < events) {
+        WaitForTick(&timer);
+        int due = DueTicks(&timer);
+        for (int i = 0; i < due; i++) {
+            auto now = chrono::steady_clock::now();
+            InputEvent event;
+            while (queue.Pop(&event)) {
+                RecordLatency(&latency, event, now);
+                QueueTurn(&game, event.key == 'w' ? UP : event.key == 'd' ? RIGHT : event.key == 's' ? DOWN : LEFT);
+            }
+            if (game.gameOver) Setup(&game, GameConfig());
+            Logic(&game);
+        }
+    }
+    producer.join();
+
+    printf("period_ms=%d events=%lld latency_mean_us=%.1f latency_max_us=%.1f\n",
+        periodMs, latency.count, MeanLatencyUs(latency), latency.maxUs);
+    return 0;
+}
+
+// Look up usernames among synthetic users, with the old linear scan and with the directory
+int RunUserLookupBench(int userCount, int lookups) {
+    vector<User> list;
+    UserDirectory directory;
+    directory.Clear();
+    directory.Reserve(userCount);
+    for (int i = 0; i < userCount; i++) {
+        User user;
+        user.username = "player" + to_string(i);
+        user.password = "secret";
+        user.highScore = i % 1000;
+        user.record = i;
+        list.push_back(user);
+        directory.Add(user);
+    }
+
+    Rng rng(11);
+    vector<string> names;
+    for (int i = 0; i < lookups; i++) names.push_back("player" + to_string(rng.Below(userCount)));
+
+    // A full scan per lookup is slow enough that a sample of the lookups is plenty
+    int scanLookups = max(1, min(lookups, 1000000000 / max(1, userCount) / 10));
+    long long found = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < scanLookups; i++) {
+        for (const User& user : list) {
+            if (user.username == names[i]) {
+                found++;
+                break;
+            }
+        }
+    }
+    auto scanned = chrono::steady_clock::now();
+    for (int i = 0; i < lookups; i++) {
+        if (directory.Find(names[i]) != nullptr) found++;
+    }
+    auto end = chrono::steady_clock::now();
+
+    double scanNs = chrono::duration<double, nano>(scanned - start).count() / scanLookups;
+    double hashNs = chrono::duration<double, nano>(end - scanned).count() / lookups;
+    printf("users=%d found=%lld scan_ns_per_lookup=%.0f hash_ns_per_lookup=%.1f speedup=%.0fx\n",
+        userCount, found, scanNs, hashNs, hashNs > 0 ? scanNs / hashNs : 0.0);
+    return 0;
+}
+
+// Step a batch of games with random actions, with and without observations
+int RunEnvBench(int games, int steps) {
+    BatchEnvConfig config;
+    config.games = games;
+    config.width = WIDTH;
+    config.height = HEIGHT;
+    config.seed = 1;
+    config.maxTicks = 1000;
+    BatchEnv env;
+    env.Reset(config);
+
+    // Actions for every step are drawn up front so the loop times only the environment
+    Rng rng(3);
+    const int actionSets = 64;
+    vector<uint8_t> actions(static_cast<size_t>(games) * actionSets);
+    for (uint8_t& action : actions) action = static_cast<uint8_t>(rng.Below(ACTION_COUNT));
+    vector<float> rewards(games);
+    vector<uint8_t> dones(games);
+    vector<uint8_t> observations(env.ObservationSize() * games);
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < steps; i++) {
+        env.Step(&actions[static_cast<size_t>(i % actionSets) * games], rewards.data(), dones.data(), nullptr);
+    }
+    auto stepped = chrono::steady_clock::now();
+    for (int i = 0; i < steps; i++) {
+        env.Step(&actions[static_cast<size_t>(i % actionSets) * games], rewards.data(), dones.data(), observations.data());
+    }
+    auto end = chrono::steady_clock::now();
+
+    double stepSeconds = chrono::duration<double>(stepped - start).count();
+    double observeSeconds = chrono::duration<double>(end - stepped).count();
+    double gameSteps = double(games) * steps;
+    printf("games=%d steps=%d episodes=%lld game_steps_per_sec=%.0f with_observation=%.0f observation_bytes=%zu\n",
+        games, steps, env.Episodes(), stepSeconds > 0 ? gameSteps / stepSeconds : 0.0,
+        observeSeconds > 0 ? gameSteps / observeSeconds : 0.0, env.ObservationSize());
+    return 0;
+}
+
+// Play the same recorded games on the generic engine and on the kernel built
+// for the board size, check they end the same way, and compare their speed.
+// Each game's moves are recorded once up front, so the timed runs are only
+// Setup() and Simulate(); the faster of five alternating rounds is reported.
+int RunKernelBench(int games, uint64_t seed, int width, int height) {
+    GameConfig config;
+    config.width = width;
+    config.height = height;
+    GameState game;
+    game.currentUser = nullptr;
+    Setup(&game, config);
+    if (game.kernel == nullptr) {
+        fprintf(stderr, "no kernel is built for a %dx%d board\n", game.width, game.height);
+        return 1;
+    }
+
+    vector<Direction> moves;
+    vector<size_t> starts;
+    for (int i = 0; i < games; i++) {
+        starts.push_back(moves.size());
+        config.seed = seed + i;
+        Setup(&game, config);
+        while (!game.gameOver) {
+            Direction input = ChaseFood(game);
+            moves.push_back(input);
+            Simulate(&game, &input, 1);
+        }
+    }
+    starts.push_back(moves.size());
+
+    const int rounds = 5;
+    double setupNs[2] = { 1e300, 1e300 };
+    double tickNs[2] = { 1e300, 1e300 };
+    long long ticks[2] = { 0, 0 };
+    long long scores[2] = { 0, 0 };
+    for (int round = 0; round < rounds; round++) {
+        for (int specialized = 0; specialized < 2; specialized++) {
+            config.specialized = specialized != 0;
+            double setup = 0;
+            double tick = 0;
+            ticks[specialized] = 0;
+            scores[specialized] = 0;
+            for (int i = 0; i < games; i++) {
+                config.seed = seed + i;
+                auto start = chrono::steady_clock::now();
+                Setup(&game, config);
+                auto setupDone = chrono::steady_clock::now();
+                ticks[specialized] += Simulate(&game, &moves[starts[i]], starts[i + 1] - starts[i]);
+                auto end = chrono::steady_clock::now();
+                setup += chrono::duration<double, nano>(setupDone - start).count();
+                tick += chrono::duration<double, nano>(end - setupDone).count();
+                scores[specialized] += game.score + game.tick;
+            }
+            setupNs[specialized] = min(setupNs[specialized], setup / games);
+            tickNs[specialized] = min(tickNs[specialized], ticks[specialized] > 0 ? tick / ticks[specialized] : 0.0);
+        }
+    }
+
+    for (int specialized = 0; specialized < 2; specialized++) {
+        printf("board=%dx%d path=%s games=%d ticks=%lld setup_ns=%.1f tick_ns=%.2f ticks_per_sec=%.0f\n",
+            game.width, game.height, specialized ? "kernel" : "generic", games, ticks[specialized],
+            setupNs[specialized], tickNs[specialized], tickNs[specialized] > 0 ? 1e9 / tickNs[specialized] : 0.0);
+    }
+    bool same = ticks[0] == ticks[1] && scores[0] == scores[1];
+    printf("setup_speedup=%.2f tick_speedup=%.2f %s\n", setupNs[0] / setupNs[1], tickNs[0] / tickNs[1],
+        same ? "PASS: both paths played the same games" : "FAIL: the paths disagree");
+    return same ? 0 : 1;
+}
+
+// One measurement of the suite: the cost of an operation at one size
+struct SuiteResult {
+    string name;
+    long long param; // the size the cost is measured against
+    double nsPerOp; // median over the repetitions
+    double minNsPerOp;
+    double bytesPerOp; // bytes produced per operation, or -1 where that means nothing
+    double writesPerOp; // write calls per operation, or -1
+};
+
+// Repetitions of each measurement; the median is reported so one preempted run does not count
+const int SUITE_REPS = 5;
+
+// Median of the repetitions, and the fastest one
+static void AddResult(vector<SuiteResult>* results, const char* name, long long param, vector<double> ns,
+    double bytesPerOp, double writesPerOp = -1) {
+    sort(ns.begin(), ns.end());
+    SuiteResult result = { name, param, ns[ns.size() / 2], ns[0], bytesPerOp, writesPerOp };
+    printf("name=%s param=%lld ns_per_op=%.1f min_ns_per_op=%.1f", name, param, result.nsPerOp, result.minNsPerOp);
+    if (bytesPerOp >= 0) printf(" bytes_per_op=%.1f", bytesPerOp);
+    if (writesPerOp >= 0) printf(" writes_per_op=%.2f", writesPerOp);
+    printf("\n");
+    results->push_back(result);
+}
+
+static double ElapsedNs(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+}
+
+// Cell the head moves into when the snake goes in dir
+static SnakeSegment NextHead(const GameState& game, Direction dir) {
+    SnakeSegment head = game.snake[0];
+    if (dir == LEFT) head.x--;
+    if (dir == RIGHT) head.x++;
+    if (dir == UP) head.y--;
+    if (dir == DOWN) head.y++;
+    return head;
+}
+
+// Grow a snake to length cells by following the Hamiltonian autopilot, which
+// never runs into itself, then stop it growing
+static void GrowSnake(GameState* game, Autopilot* pilot, size_t length) {
+    game->growth = static_cast<int>(length - min(length, game->snake.size()));
+    while (game->snake.size() < length && !game->gameOver) {
+        Direction move = ChooseMove(pilot, *game);
+        Simulate(game, &move, 1);
+    }
+    game->growth = 0;
+}
+
+// Record the autopilot's next moves on a copy of the game, so the timed replay
+// runs only the engine. With feed set, food is put in front of the head before
+// every move and each tick eats and places new food.
+static vector<Direction> RecordMoves(GameState game, Autopilot* pilot, size_t count, bool feed) {
+    vector<Direction> moves;
+    while (moves.size() < count && !game.gameOver) {
+        Direction move = ChooseMove(pilot, game);
+        if (feed) {
+            SnakeSegment next = NextHead(game, move);
+            game.foodX = next.x;
+            game.foodY = next.y;
+        }
+        Simulate(&game, &move, 1);
+        moves.push_back(move);
+    }
+    return moves;
+}
+
+// Time replaying recorded moves from the same starting state; returns ns per tick
+static double ReplayMoves(const GameState& start, const vector<Direction>& moves, bool feed) {
+    GameState game = start;
+    double ns = 0;
+    if (feed) {
+        // The food has to be moved before every tick, so each tick is timed on its own
+        for (Direction move : moves) {
+            SnakeSegment next = NextHead(game, move);
+            game.foodX = next.x;
+            game.foodY = next.y;
+            auto begin = chrono::steady_clock::now();
+            Simulate(&game, &move, 1);
+            ns += ElapsedNs(begin);
+        }
+    }
+    else {
+        auto begin = chrono::steady_clock::now();
+        Simulate(&game, moves.data(), moves.size());
+        ns = ElapsedNs(begin);
+    }
+    return moves.empty() ? 0 : ns / moves.size();
+}
+
+// Logic() cost against snake length on a 200x200 board
+static void BenchLogic(vector<SuiteResult>* results) {
+    const size_t lengths[] = { 4, 64, 1024, 16384 };
+    const size_t ticks = 20000;
+    for (size_t length : lengths) {
+        GameConfig config;
+        config.width = 200;
+        config.height = 200;
+        config.seed = 1;
+        GameState game;
+        game.currentUser = nullptr;
+        Setup(&game, config);
+        Autopilot pilot;
+        InitAutopilot(&pilot, game, HAMILTONIAN, 1000000);
+        GrowSnake(&game, &pilot, length);
+
+        vector<Direction> moves = RecordMoves(game, &pilot, ticks, false);
+        vector<double> ns;
+        for (int rep = 0; rep < SUITE_REPS; rep++) ns.push_back(ReplayMoves(game, moves, false));
+        AddResult(results, "logic_tick", static_cast<long long>(game.snake.size()), ns, -1);
+    }
+}
+
+// Food placement cost against how much of the board the snake fills: every
+// timed tick eats, so it includes taking the head cell off the free list and
+// drawing a new food cell
+static void BenchFood(vector<SuiteResult>* results) {
+    const int percents[] = { 10, 50, 90, 99 };
+    const size_t ticks = 2000;
+    for (int percent : percents) {
+        GameConfig config;
+        config.width = 200;
+        config.height = 200;
+        config.seed = 2;
+        GameState game;
+        game.currentUser = nullptr;
+        Setup(&game, config);
+        Autopilot pilot;
+        InitAutopilot(&pilot, game, HAMILTONIAN, 1000000);
+
+        // Leave room for the segments the timed ticks add
+        size_t inside = static_cast<size_t>(config.width - 2) * (config.height - 2);
+        size_t length = min(inside * percent / 100, inside - ticks - 1);
+        GrowSnake(&game, &pilot, length);
+
+        vector<Direction> moves = RecordMoves(game, &pilot, ticks, true);
+        vector<double> ns;
+        for (int rep = 0; rep < SUITE_REPS; rep++) ns.push_back(ReplayMoves(game, moves, true));
+        AddResult(results, "food_tick", percent, ns, -1);
+    }
+}
+
+// Snapshot encode and restore cost against snake length on a 200x200 board;
+// the free-cell list, which shrinks as the snake grows, is most of each snapshot
+static void BenchSnapshot(vector<SuiteResult>* results) {
+    const size_t lengths[] = { 4, 64, 1024, 16384 };
+    const int snapshots = 200;
+    for (size_t length : lengths) {
+        GameConfig config;
+        config.width = 200;
+        config.height = 200;
+        config.seed = 3;
+        GameState game;
+        game.currentUser = nullptr;
+        Setup(&game, config);
+        Autopilot pilot;
+        InitAutopilot(&pilot, game, HAMILTONIAN, 1000000);
+        GrowSnake(&game, &pilot, length);
+
+        vector<uint8_t> bytes;
+        GameState restored = game;
+        vector<double> encodeNs, decodeNs;
+        for (int rep = 0; rep < SUITE_REPS; rep++) {
+            auto begin = chrono::steady_clock::now();
+            for (int i = 0; i < snapshots; i++) EncodeSnapshot(game, &bytes);
+            encodeNs.push_back(ElapsedNs(begin) / snapshots);
+            begin = chrono::steady_clock::now();
+            for (int i = 0; i < snapshots; i++) DecodeSnapshot(bytes.data(), bytes.size(), &restored);
+            decodeNs.push_back(ElapsedNs(begin) / snapshots);
+        }
+        long long param = static_cast<long long>(game.snake.size());
+        AddResult(results, "snapshot_encode", param, encodeNs, static_cast<double>(bytes.size()));
+        AddResult(results, "snapshot_decode", param, decodeNs, -1);
+    }
+}
+
+// Encode the game screen for the terminal, diffed against the last frame;
+// returns the bytes Present() produced
+static size_t PresentGameFrame(const GameState& game, GameLayer* layer, Renderer* renderer) {
+    ComposeGameFrame(game, layer, nullptr, &renderer->back);
+    return Present(renderer);
+}
+
+// Draw() cost and bytes per frame, for frames diffed against the previous one
+// and for full repaints, on the default board and on a large scrolling one
+static void BenchDraw(vector<SuiteResult>* results) {
+    const int sizes[] = { WIDTH, 200 };
+    const int frames = 2000;
+    for (int size : sizes) {
+        GameConfig config;
+        config.width = size;
+        config.height = size == WIDTH ? HEIGHT : size;
+        config.seed = 3;
+        GameState start;
+        start.currentUser = nullptr;
+        Setup(&start, config);
+        Autopilot pilot;
+        InitAutopilot(&pilot, start, HAMILTONIAN, 1000000);
+        GrowSnake(&start, &pilot, 64);
+        vector<Direction> moves = RecordMoves(start, &pilot, frames, false);
+
+        for (int full = 0; full < 2; full++) {
+            vector<double> ns;
+            double bytes = 0;
+            for (int rep = 0; rep < SUITE_REPS; rep++) {
+                GameState game = start;
+                Renderer* renderer = new Renderer();
+                GameLayer* layer = new GameLayer;
+                ResetRenderer(renderer);
+                PresentGameFrame(game, layer, renderer);
+                double total = 0;
+                size_t written = 0;
+                for (Direction move : moves) {
+                    Simulate(&game, &move, 1);
+                    if (full) ResetRenderer(renderer);
+                    auto begin = chrono::steady_clock::now();
+                    written += PresentGameFrame(game, layer, renderer);
+                    total += ElapsedNs(begin);
+                }
+                delete layer;
+                delete renderer;
+                ns.push_back(total / moves.size());
+                bytes = double(written) / moves.size();
+            }
+            AddResult(results, full ? "draw_full_frame" : "draw_diff_frame", size, ns, bytes);
+        }
+    }
+}
+
+// Cost of building the game screen's back frame, before it is encoded: with
+// the static layer rebuilt every frame, as when nothing was cached, or copied
+// from the cached layer with only the live cells drawn
+static void BenchCompose(vector<SuiteResult>* results) {
+    const int sizes[] = { WIDTH, 200 };
+    for (int size : sizes) {
+        GameConfig config;
+        config.width = size;
+        config.height = size == WIDTH ? HEIGHT : size;
+        config.seed = 3;
+        GameState start;
+        start.currentUser = nullptr;
+        Setup(&start, config);
+        Autopilot pilot;
+        InitAutopilot(&pilot, start, HAMILTONIAN, 1000000);
+        GrowSnake(&start, &pilot, 64);
+        vector<Direction> moves = RecordMoves(start, &pilot, 2000, false);
+
+        for (int layered = 0; layered < 2; layered++) {
+            vector<double> ns;
+            Frame* frame = new Frame;
+            GameLayer* layer = new GameLayer;
+            for (int rep = 0; rep < SUITE_REPS; rep++) {
+                GameState game = start;
+                double total = 0;
+                for (Direction move : moves) {
+                    Simulate(&game, &move, 1);
+                    auto begin = chrono::steady_clock::now();
+                    if (!layered) layer->width = 0; // forces a rebuild
+                    ComposeGameFrame(game, layer, nullptr, frame);
+                    total += ElapsedNs(begin);
+                }
+                ns.push_back(total / moves.size());
+            }
+            delete layer;
+            delete frame;
+            AddResult(results, layered ? "compose_layered_frame" : "compose_redrawn_frame", size, ns, -1);
+        }
+    }
+}
+
+// Encodes frames as the ANSI backend does and drops them, counting one write
+// per frame. On Windows the ANSI backend always writes to the real console, so
+// the benchmarks draw on this instead.
+class DiscardConsole : public Console {
+public:
+    void Open(const char*) override {}
+    void Close() override {}
+
+    size_t Show(Renderer* renderer) override {
+        renderer->utf8 = true;
+        size_t size = Present(renderer);
+        if (size > 0) {
+            writes++;
+            bytes += static_cast<long long>(size);
+        }
+        return size;
+    }
+
+    int ReadKey(int) override {
+        return KEY_NONE;
+    }
+};
+
+// The console frames are measured on: the ANSI backend writing to the null
+// device, or a DiscardConsole on Windows. *sink is the device, to close with
+// the console, or nullptr.
+static Console* OpenSinkConsole(FILE** sink) {
+#ifdef _WIN32
+    *sink = nullptr;
+    Console* console = new DiscardConsole;
+#else
+    *sink = fopen("/dev/null", "w");
+    if (*sink == nullptr) return nullptr;
+    Console* console = CreateAnsiConsole(fileno(*sink), fileno(*sink));
+#endif
+    console->Open("SnakeBench");
+    return console;
+}
+
+static void CloseSinkConsole(Console* console, FILE* sink) {
+    console->Close();
+    delete console;
+    if (sink != nullptr) fclose(sink);
+}
+
+// Frames put on screen by the ANSI backend, written to the null device: the
+// cost of building, encoding and writing each frame, and its bytes and write calls
+static void BenchConsole(vector<SuiteResult>* results) {
+    FILE* sink;
+    Console* console = OpenSinkConsole(&sink);
+    if (console == nullptr) return;
+
+    GameConfig config;
+    config.seed = 4;
+    GameState start;
+    start.currentUser = nullptr;
+    Setup(&start, config);
+    Autopilot pilot;
+    InitAutopilot(&pilot, start, HAMILTONIAN, 1000000);
+    GrowSnake(&start, &pilot, 32);
+    vector<Direction> moves = RecordMoves(start, &pilot, 2000, false);
+
+    for (int full = 0; full < 2; full++) {
+        vector<double> ns;
+        long long bytes = 0;
+        long long writes = 0;
+        for (int rep = 0; rep < SUITE_REPS; rep++) {
+            GameState game = start;
+            Renderer* renderer = new Renderer();
+            GameLayer* layer = new GameLayer;
+            ResetRenderer(renderer);
+            DrawGame(game, layer, nullptr, renderer, console);
+            double total = 0;
+            console->bytes = 0;
+            console->writes = 0;
+            for (Direction move : moves) {
+                Simulate(&game, &move, 1);
+                if (full) ResetRenderer(renderer);
+                auto begin = chrono::steady_clock::now();
+                DrawGame(game, layer, nullptr, renderer, console);
+                total += ElapsedNs(begin);
+            }
+            delete layer;
+            delete renderer;
+            ns.push_back(total / moves.size());
+            bytes = console->bytes;
+            writes = console->writes;
+        }
+        AddResult(results, full ? "console_full_frame" : "console_diff_frame", WIDTH, ns,
+            double(bytes) / moves.size(), double(writes) / moves.size());
+    }
+    CloseSinkConsole(console, sink);
+}
+
+// Synthetic user i, with a spread of scores
+static User MakeUser(int i) {
+    User user;
+    user.username = "player" + to_string(i);
+    user.password = "secret";
+    user.highScore = static_cast<int>((i * 2654435761u) % 100000);
+    user.record = NO_RECORD;
+    return user;
+}
+
+// LoadUsers() and SaveUser() against the number of users in the store: registering
+// appends a record, a new high score rewrites one field, and loading reads the
+// whole store and builds the directory and leaderboard
+static void BenchUserStore(vector<SuiteResult>* results) {
+    const int counts[] = { 1000, 10000, 100000 };
+    const char* path = "bench_users.dat";
+    for (int count : counts) {
+        vector<double> appendNs;
+        vector<double> loadNs;
+        vector<double> saveNs;
+        for (int rep = 0; rep < SUITE_REPS; rep++) {
+            remove(path);
+            UserStore store = { nullptr, 0 };
+            if (!OpenUserStore(&store, path, "")) {
+                printf("error=cannot_open_store path=%s\n", path);
+                return;
+            }
+            vector<User> users;
+            for (int i = 0; i < count; i++) users.push_back(MakeUser(i));
+            auto begin = chrono::steady_clock::now();
+            for (User& user : users) AppendUser(&store, &user);
+            appendNs.push_back(ElapsedNs(begin) / count);
+            CloseUserStore(&store);
+
+            begin = chrono::steady_clock::now();
+            store = { nullptr, 0 };
+            OpenUserStore(&store, path, "");
+            vector<User> stored;
+            ReadUsers(&store, &stored);
+            UserDirectory directory;
+            Leaderboard leaderboard;
+            directory.Reserve(stored.size());
+            for (const User& user : stored) {
+                User* added = directory.Add(user);
+                if (added != nullptr) leaderboard.Insert(added);
+            }
+            loadNs.push_back(ElapsedNs(begin));
+
+            const int saves = 1000;
+            Rng rng(5);
+            begin = chrono::steady_clock::now();
+            for (int i = 0; i < saves; i++) {
+                User* user = directory.Find("player" + to_string(rng.Below(count)));
+                leaderboard.UpdateScore(user, user->highScore + 1);
+                SaveHighScore(&store, *user);
+            }
+            saveNs.push_back(ElapsedNs(begin) / saves);
+            CloseUserStore(&store);
+        }
+        remove(path);
+        AddResult(results, "users_append", count, appendNs, -1);
+        AddResult(results, "users_load", count, loadNs, -1);
+        AddResult(results, "users_save_high_score", count, saveNs, -1);
+    }
+}
+
+// Leaderboard display cost against the number of ranked users: the game's own
+// screen composed over its layer and diffed against the screen before it
+static void BenchLeaderboard(vector<SuiteResult>* results) {
+    const int counts[] = { 1000, 10000, 100000, 1000000 };
+    const int displays = 2000;
+    for (int count : counts) {
+        vector<User> users;
+        users.reserve(count);
+        for (int i = 0; i < count; i++) users.push_back(MakeUser(i));
+        Leaderboard leaderboard;
+        for (const User& user : users) leaderboard.Insert(&user);
+
+        Renderer* renderer = new Renderer();
+        ResetRenderer(renderer);
+        Frame* layer = new Frame;
+        BuildLeaderboardLayer(layer);
+        vector<double> ns;
+        size_t written = 0;
+        for (int rep = 0; rep < SUITE_REPS; rep++) {
+            written = 0;
+            double total = 0;
+            for (int i = 0; i < displays; i++) {
+                // Another screen is up before each visit, as the menu is in the game
+                ClearFrame(&renderer->back);
+                Present(renderer);
+                auto begin = chrono::steady_clock::now();
+                ComposeLeaderboard(leaderboard, *layer, &renderer->back);
+                written += Present(renderer);
+                total += ElapsedNs(begin);
+            }
+            ns.push_back(total / displays);
+        }
+        delete layer;
+        delete renderer;
+        AddResult(results, "leaderboard_display", count, ns, double(written) / displays);
+    }
+}
+
+// Write the results as JSON, one object per measurement
+static bool WriteSuiteJson(const vector<SuiteResult>& results, const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+    fprintf(file, "{\n  \"suite\": \"SnakeBench\",\n  \"reps\": %d,\n  \"results\": [\n", SUITE_REPS);
+    for (size_t i = 0; i < results.size(); i++) {
+        const SuiteResult& result = results[i];
+        fprintf(file, "    {\"name\": \"%s\", \"param\": %lld, \"ns_per_op\": %.1f, \"min_ns_per_op\": %.1f",
+            result.name.c_str(), result.param, result.nsPerOp, result.minNsPerOp);
+        if (result.bytesPerOp >= 0) fprintf(file, ", \"bytes_per_op\": %.1f", result.bytesPerOp);
+        if (result.writesPerOp >= 0) fprintf(file, ", \"writes_per_op\": %.2f", result.writesPerOp);
+        fprintf(file, "}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    return fclose(file) == 0;
+}
+
+// Run every hot-path measurement and write them to path
+int RunSuite(const char* path) {
+    vector<SuiteResult> results;
+    BenchLogic(&results);
+    BenchFood(&results);
+    BenchSnapshot(&results);
+    BenchDraw(&results);
+    BenchCompose(&results);
+    BenchConsole(&results);
+    BenchUserStore(&results);
+    BenchLeaderboard(&results);
+
+    if (!WriteSuiteJson(results, path)) {
+        printf("error=cannot_write path=%s\n", path);
+        return 1;
+    }
+    printf("results=%zu output=%s\n", results.size(), path);
+    return 0;
+}
+
+// Play games through the console front end's own steady-state code: keys
+// queued as the input thread queues them and handled by RunGameTick(), which
+// steers, records the replay and runs the logic, then DrawGame() with a
+// logged-in player's line and the profiler HUD, written to the null device. One game
+// runs in demo mode, on the autopilot path. Any heap allocation after a game's
+// first frame is reported, and fails the check.
+int RunAllocCheck(int maxTicks) {
+    FILE* sink;
+    Console* console = OpenSinkConsole(&sink);
+    if (console == nullptr) return 1;
+    Renderer* renderer = new Renderer();
+    ResetRenderer(renderer);
+    GameLayer* layer = new GameLayer;
+    Profiler* profiler = new Profiler;
+    ResetProfiler(profiler);
+    InputQueue* keys = new InputQueue;
+    GameInput input = { keys, { 0, 0, 0 }, false, false };
+    User player = { "benchmark", "", 0, 0 };
+    Replay replay;
+    Autopilot pilot;
+    GameState game;
+
+    struct Case {
+        int width;
+        int height;
+        AutopilotStrategy strategy;
+        bool demo;
+    };
+    const Case cases[] = {
+        { WIDTH, HEIGHT, GREEDY_BFS, false },
+        { WIDTH, HEIGHT, HAMILTONIAN, true },
+        { 200, 200, GREEDY_BFS, false }, // larger than the view, so the board scrolls
+    };
+    const char keyFor[] = { 0, 'a', 'd', 'w', 's' }; // by Direction
+
+    long long failures = 0;
+    for (const Case& c : cases) {
+        GameConfig config;
+        config.width = c.width;
+        config.height = c.height;
+        config.seed = 11;
+        Setup(&game, config);
+        game.currentUser = c.demo ? nullptr : &player;
+        StartRecording(&replay, config);
+        InitAutopilot(&pilot, game, c.strategy, 1000000);
+
+        // The HUD is on throughout: P in the first tick, or set for the demo,
+        // where any key ends the game
+        input.showHud = c.demo;
+        input.quit = false;
+        if (!c.demo) keys->Push(InputEvent{ 'p', chrono::steady_clock::now() });
+        DrawGame(game, layer, input.showHud ? profiler : nullptr, renderer, console);
+
+        long long before = heapAllocations.load();
+        int ticks = 0;
+        while (!game.gameOver && ticks < maxTicks) {
+            FrameSample sample = {};
+            if (!c.demo) {
+                // The autopilot stands in for the player, pressing the key for its move
+                Direction move = ChooseMove(&pilot, game);
+                if (move != STOP) keys->Push(InputEvent{ keyFor[move], chrono::steady_clock::now() });
+            }
+            RunGameTick(&input, &game, &replay, c.demo ? &pilot : nullptr, profiler, &sample);
+            {
+                ProfileScope scope(&profiler->metrics[METRIC_DRAW], &sample.drawNs);
+                sample.bytes = DrawGame(game, layer, input.showHud ? profiler : nullptr, renderer, console);
+            }
+            sample.tick = game.tick;
+            RecordFrame(profiler, sample);
+            ticks++;
+        }
+        FinishRecording(&replay, game);
+        long long allocations = heapAllocations.load() - before;
+        failures += allocations;
+
+        printf("board=%dx%d strategy=%s%s ticks=%d length=%zu turns=%zu hud=%d allocations=%lld\n",
+            game.width, game.height, c.strategy == HAMILTONIAN ? "hamiltonian" : "greedy", c.demo ? " demo" : "",
+            ticks, game.snake.size(), replay.events.size(), input.showHud ? 1 : 0, allocations);
+    }
+
+    CloseSinkConsole(console, sink);
+    delete keys;
+    delete profiler;
+    delete layer;
+    delete renderer;
+    printf("%s\n", failures == 0 ? "PASS: no allocations after the first frame" : "FAIL: the game loop allocated");
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    // SnakeBench allocs [maxTicks]
+    if (argc > 1 && string(argv[1]) == "allocs") {
+        return RunAllocCheck(argc > 2 ? atoi(argv[2]) : 100000);
+    }
+
+    // SnakeBench suite [results.json]
+    if (argc > 1 && string(argv[1]) == "suite") {
+        return RunSuite(argc > 2 ? argv[2] : "bench.json");
+    }
+
+    // SnakeBench env [games] [steps]
+    if (argc > 1 && string(argv[1]) == "env") {
+        return RunEnvBench(argc > 2 ? atoi(argv[2]) : 4096, argc > 3 ? atoi(argv[3]) : 1000);
+    }
+
+    // SnakeBench kernels [games] [seed] [width] [height]
+    if (argc > 1 && string(argv[1]) == "kernels") {
+        return RunKernelBench(argc > 2 ? atoi(argv[2]) : 100000, argc > 3 ? strtoull(argv[3], nullptr, 10) : 1,
+            argc > 4 ? atoi(argv[4]) : WIDTH, argc > 5 ? atoi(argv[5]) : HEIGHT);
+    }
+
+    // SnakeBench users [count] [lookups]
+    if (argc > 1 && string(argv[1]) == "users") {
+        return RunUserLookupBench(argc > 2 ? atoi(argv[2]) : 1000000, argc > 3 ? atoi(argv[3]) : 1000000);
+    }
+
+    // SnakeBench input [events] [periodMs]
+    if (argc > 1 && string(argv[1]) == "input") {
+        return RunInputBench(argc > 2 ? atoi(argv[2]) : 100, argc > 3 ? atoi(argv[3]) : 10);
+    }
+
+    // SnakeBench timer [ticks] [periodMs]
+    if (argc > 1 && string(argv[1]) == "timer") {
+        return RunTimerBench(argc > 2 ? atoi(argv[2]) : 200, argc > 3 ? atoi(argv[3]) : 10);
+    }
+
+    // SnakeBench [games] [seed] [width] [height]
+    int games = argc > 1 ? atoi(argv[1]) : 100000;
+    uint64_t seed = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1;
+    GameConfig config;
+    if (argc > 3) config.width = atoi(argv[3]);
+    if (argc > 4) config.height = atoi(argv[4]);
+
+    GameState game;
+    game.currentUser = nullptr;
+
+    long long ticks = 0;
+    long long totalScore = 0;
+    double setupSeconds = 0;
+    double tickSeconds = 0;
+    for (int i = 0; i < games; i++) {
+        // Setup is timed apart from the ticks since it is the only step that scales with the board
+        auto start = chrono::steady_clock::now();
+        config.seed = seed + i;
+        Setup(&game, config);
+        auto setupDone = chrono::steady_clock::now();
+        while (!game.gameOver) {
+            Direction input = ChaseFood(game);
+            ticks += Simulate(&game, &input, 1);
+        }
+        auto end = chrono::steady_clock::now();
+        setupSeconds += chrono::duration<double>(setupDone - start).count();
+        tickSeconds += chrono::duration<double>(end - setupDone).count();
+        totalScore += game.score;
+    }
+
+    printf("board=%dx%d games=%d ticks=%lld avg_score=%.2f setup_seconds=%.3f tick_seconds=%.3f ticks_per_sec=%.0f\n",
+        game.width, game.height, games, ticks, games > 0 ? double(totalScore) / games : 0.0,
+        setupSeconds, tickSeconds, tickSeconds > 0 ? ticks / tickSeconds : 0.0);
+    return 0;
+}
@@ -1,778 +1,829 @@
-﻿#include <iostream>
-#include <conio.h>
-#include <windows.h>
-#include <fstream>
-#include <vector>
+﻿#include <vector>
 #include <string>
 #include <algorithm>
-#include <ctime>
-#include <iomanip>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include "Arena.h"
+#include "Autopilot.h"
+#include "Console.h"
+#include "Engine.h"
+#include "GameLoop.h"
+#include "InputQueue.h"
+#include "Leaderboard.h"
+#include "Profiler.h"
+#include "Renderer.h"
+#include "Replay.h"
+#include "Screens.h"
+#include "Snapshot.h"
+#include "TickTimer.h"
+#include "UserDirectory.h"
+#include "UserStore.h"
 
 using namespace std;
 
-// Console color codes
-enum Color {
-    BLACK = 0,
-    BLUE = 1,
-    GREEN = 2,
-    CYAN = 3,
-    RED = 4,
-    MAGENTA = 5,
-    BROWN = 6,
-    LIGHTGRAY = 7,
-    DARKGRAY = 8,
-    LIGHTBLUE = 9,
-    LIGHTGREEN = 10,
-    LIGHTCYAN = 11,
-    LIGHTRED = 12,
-    LIGHTMAGENTA = 13,
-    YELLOW = 14,
-    WHITE = 15
+// Terminal the session draws on, and the one renderer every screen is built in,
+// so moving between screens only writes the cells that differ
+Console* console = nullptr;
+Renderer* screen = nullptr;
+
+// The parts of each screen that never change: banners, boxes, labels and the
+// board walls. They are composed once and copied into the back frame in one go,
+// so showing a screen only adds its live fields (score, names, typed text).
+struct ScreenLayers {
+    Frame mainMenu;
+    Frame login;
+    Frame registerMenu;
+    Frame gameOver;
+    Frame leaderboard;
+    GameLayer game;
 };
-
-// Constants
-const int WIDTH = 30;
-const int HEIGHT = 20;
-const char SNAKE_BODY = 'O';
-const char SNAKE_HEAD = '@';
-const char FOOD = '*';
-const char EMPTY = ' ';
-const char WALL_HORIZONTAL = '═';
-const char WALL_VERTICAL = '║';
-const char WALL_CORNER_TL = '╔';
-const char WALL_CORNER_TR = '╗';
-const char WALL_CORNER_BL = '╚';
-const char WALL_CORNER_BR = '╝';
-
-// Directions
-enum Direction { STOP = 0, LEFT, RIGHT, UP, DOWN };
-
-// User structure for login system
-struct User {
-    string username;
-    string password;
-    int highScore;
+ScreenLayers layers;
+
+// Users are kept in users.dat, imported from the old users.txt on first run
+UserStore userStore = { nullptr, 0 };
+
+// Keys read by the input thread while a game runs, drained every tick by
+// RunGameTick(); X there puts the game aside in the player's save file rather
+// than ending it
+InputQueue keyQueue;
+atomic<bool> inputRunning(false);
+GameInput gameInput = { &keyQueue, { 0, 0, 0 }, false, false };
+
+// Phase timings of the game loop; P toggles the HUD line during a game, and the
+// figures are written to profile.json and profile.csv on exit
+Profiler profiler;
+
+// A user record waiting to be written by the saver thread
+struct SaveRequest {
+    User* user;
+    int highScore; // copied when queued, so the saver never reads a score the game is changing
 };
 
-// Snake segment structure
-struct SnakeSegment {
-    int x, y;
+// Records are written to userStore by a background thread so no screen waits on
+// the disk. Once it runs, the saver is the only thread that touches the store
+// and User::record; usernames and passwords never change after registration.
+mutex saveMutex;
+condition_variable saveReady;
+vector<SaveRequest> pendingSaves;
+bool saverStopping = false;
+atomic<bool> saveFailed(false);
+
+// The running game's replay up to its latest autosave point, for the saver
+// thread to play back and write to the player's save file, so a crash loses at
+// most AUTOSAVE_TICKS ticks. The game thread only appends the turns since the
+// last autosave, into a buffer sized when the game starts, so an autosave costs
+// it neither an allocation nor time that grows with the board. The saver copies
+// the request out under saveMutex and rebuilds and writes the game with
+// saveFileMutex held, taken before saveMutex is let go, so a game that has
+// ended can wait out a write in progress before writing or removing the file.
+struct AutosaveRequest {
+    string path;
+    string owner;
+    Replay replay; // ticks is the tick to save at
+    bool pending;
+};
+AutosaveRequest autosave;
+mutex saveFileMutex;
+
+// Where the session is: each screen returns the state to go to next
+enum SessionState {
+    SESSION_MENU = 0,
+    SESSION_PLAYING,
+    SESSION_GAME_OVER,
+    SESSION_EXIT
 };
 
-// Game state structure
-struct GameState {
-    bool gameOver;
-    int score;
-    Direction dir;
-    vector<SnakeSegment> snake; // Dynamic data structure for snake body
-    int foodX, foodY;
-    User* currentUser; // Pointer to current user
-    int speed; // Game speed (milliseconds between updates)
+// Everything that lives for the whole run of the program. Users are loaded once
+// and kept in memory, and every game reuses the same game state, replay and
+// autopilot, so a long session runs in constant memory.
+struct Session {
+    SessionState state;
+    UserDirectory users;
+    Leaderboard leaderboard;
+    User* currentUser;
+    bool demo; // the autopilot plays the next game
+    bool newHighScore; // set by the last game
+    bool saved; // the last game was put aside to resume later
+    bool resume; // the next game continues the saved one, already loaded into game and replay
+    GameConfig config;
+    GameState game;
+    Replay replay;
+    Autopilot* pilot;
 };
 
+// Rows of the boxes whose contents are filled in over a cached layer
+const int GAME_OVER_BOX_Y = 13;
+
+// Ticks between copies of a running game written to its save file. Each
+// player has one save file (see SaveGamePath()), kept from an X until the game
+// is resumed and finished, or another one is started in its place.
+const uint32_t AUTOSAVE_TICKS = 100;
+
+// Multiplayer: two players on the keyboard against bots, at a fixed speed
+const int ARENA_PLAYERS = 2;
+const int ARENA_BOTS = 6;
+const int ARENA_FOOD_ITEMS = 6;
+const int ARENA_SPEED = 120;
+
 // Function prototypes
-void SetConsoleColor(int textColor, int bgColor);
-void CenterText(const string& text, int width, int textColor = WHITE, int bgColor = BLACK);
-void DrawBox(int x, int y, int width, int height, int textColor = WHITE, int bgColor = BLACK);
-void Setup(GameState* game);
-void Draw(const GameState& game);
-void Input(GameState* game);
-void Logic(GameState* game);
-void DrawMainMenu();
-void DrawLoginMenu();
-void DrawRegisterMenu();
-bool Login(vector<User>& users, User** currentUser);
-bool Register(vector<User>& users);
-void SaveUsers(const vector<User>& users);
-vector<User> LoadUsers();
-void DisplayLeaderboard(const vector<User>& users);
-void UpdateLeaderboard(vector<User>& users, User* currentUser, int score);
-void DrawGameOver(int score, bool newHighScore);
-void GotoXY(int x, int y);
-void HideCursor();
-
-int main() {
-    // Set console title and size
-    SetConsoleTitle(TEXT("Advanced Snake Game"));
-    system("mode con: cols=80 lines=25");
-    HideCursor();
-
-    srand(static_cast<unsigned int>(time(0)));
-
-    // Load users from file
-    vector<User> users = LoadUsers();
-    User* currentUser = nullptr;
-
-    // Main menu
-    int choice;
-    bool loggedIn = false;
-
-    do {
-        DrawMainMenu();
-        choice = _getch() - '0'; // Convert char to int
-
-        switch (choice) {
-        case 1: // Login
-            loggedIn = Login(users, &currentUser);
-            if (loggedIn) {
-                system("cls");
-                SetConsoleColor(LIGHTGREEN, BLACK);
-                CenterText("Logged in as " + currentUser->username, 80);
-                SetConsoleColor(WHITE, BLACK);
-                Sleep(1500);
-                choice = 0; // To start the game
-            }
+void BuildScreenLayers();
+void ShowLayer(const Frame& layer);
+void ShowMessage(const string& text, int textColor);
+string ReadLine(int x, int y, bool masked);
+SessionState RunMenu(Session* session);
+SessionState PlayGame(Session* session);
+SessionState ShowGameOver(Session* session);
+bool OfferResume(Session* session);
+void PlayArena();
+uint64_t NewSeed();
+void DrawArenaScreen(const Arena& arena, Renderer* renderer);
+void ReadKeys();
+void BuildMainMenuLayer(Frame* frame);
+void BuildLoginLayer(Frame* frame);
+void BuildRegisterLayer(Frame* frame);
+void BuildGameOverLayer(Frame* frame);
+bool Login(UserDirectory& users, User** currentUser);
+bool Register(UserDirectory& users, User** registeredUser);
+void SaveUser(User* user);
+void FlushUsers();
+void StartAutosave(const string& path, const string& owner, const GameState& game, const Replay& replay);
+void QueueAutosave(const GameState& game, const Replay& replay);
+void StopAutosave();
+void ReportSaveErrors();
+void LoadUsers(UserDirectory* users, Leaderboard* leaderboard);
+void DisplayLeaderboard(const Leaderboard& leaderboard);
+void UpdateLeaderboard(Leaderboard& leaderboard, User* currentUser, int score);
+void DrawGameOver(int score, bool newHighScore, bool won, bool saved, size_t rank);
+
+int main(int argc, char* argv[]) {
+    // The terminal is set up once for the whole session
+    console = CreateConsole();
+    console->Open("Advanced Snake Game");
+    screen = new Renderer;
+    ResetRenderer(screen);
+    BuildScreenLayers();
+    ResetProfiler(&profiler);
+
+    Session session;
+    session.state = SESSION_MENU;
+    session.currentUser = nullptr;
+    session.demo = false;
+    session.newHighScore = false;
+    session.saved = false;
+    session.resume = false;
+    // Board size can be given on the command line: SnakeGameV2 [width] [height]
+    if (argc > 1) session.config.width = atoi(argv[1]);
+    if (argc > 2) session.config.height = atoi(argv[2]);
+    session.game.currentUser = nullptr;
+    session.pilot = new Autopilot;
+
+    // Load users from file, once
+    {
+        ProfileScope scope(&profiler.metrics[METRIC_LOAD_USERS]);
+        LoadUsers(&session.users, &session.leaderboard);
+    }
+    thread saver(FlushUsers);
+
+    // Moving between screens is a state change, not a restart
+    while (session.state != SESSION_EXIT) {
+        switch (session.state) {
+        case SESSION_MENU:
+            session.state = RunMenu(&session);
             break;
-        case 2: // Register
-            if (Register(users)) {
-                system("cls");
-                SetConsoleColor(LIGHTGREEN, BLACK);
-                CenterText("Registration successful!", 80);
-                SetConsoleColor(WHITE, BLACK);
-                SaveUsers(users);
-            }
-            Sleep(1500);
+        case SESSION_PLAYING:
+            session.state = PlayGame(&session);
             break;
-        case 3: // View Leaderboard
-            DisplayLeaderboard(users);
+        case SESSION_GAME_OVER:
+            session.state = ShowGameOver(&session);
             break;
-        case 4: // Play as Guest
-            currentUser = nullptr;
-            choice = 0; // To start the game
+        default:
+            session.state = SESSION_EXIT;
             break;
-        case 5: // Exit
-            system("cls");
-            SetConsoleColor(YELLOW, BLACK);
-            CenterText("Thanks for playing!", 80);
-            SetConsoleColor(WHITE, BLACK);
-            Sleep(1500);
-            return 0;
         }
+    }
 
-    } while (choice != 0);
+    // Let the saver write what is still queued
+    {
+        lock_guard<mutex> lock(saveMutex);
+        saverStopping = true;
+    }
+    saveReady.notify_one();
+    saver.join();
+    ReportSaveErrors();
+    delete session.pilot;
+
+    WriteProfileJson(profiler, "profile.json");
+    WriteTraceCsv(profiler, "profile.csv");
+    ShowMessage("Thanks for playing!", YELLOW);
+    console->Close();
+    delete console;
+    delete screen;
+    return 0;
+}
 
-    // Game initialization
-    GameState game;
-    game.currentUser = currentUser;
-    Setup(&game);
-
-    // Game loop
-    while (!game.gameOver) {
-        Draw(game);
-        Input(&game);
-        Logic(&game);
-        Sleep(game.speed); // Game speed
+// Show the main menu and handle one choice
+SessionState RunMenu(Session* session) {
+    ReportSaveErrors();
+    ShowLayer(layers.mainMenu);
+    int choice = console->ReadKey(-1) - '0'; // Convert char to int
+
+    switch (choice) {
+    case 1: // Login
+        if (Login(session->users, &session->currentUser)) {
+            ShowMessage("Logged in as " + session->currentUser->username, LIGHTGREEN);
+            session->demo = false;
+            session->resume = OfferResume(session);
+            return SESSION_PLAYING;
+        }
+        break;
+    case 2: // Register
+        User* newUser;
+        if (Register(session->users, &newUser)) {
+            SaveUser(newUser);
+            session->leaderboard.Insert(newUser);
+            ShowMessage("Registration successful!", LIGHTGREEN);
+        }
+        break;
+    case 3: // View Leaderboard
+        DisplayLeaderboard(session->leaderboard);
+        break;
+    case 4: // Play as Guest
+        session->currentUser = nullptr;
+        session->demo = false;
+        session->resume = OfferResume(session);
+        return SESSION_PLAYING;
+    case 5: // Exit
+        return SESSION_EXIT;
+    case 6: // Demo Mode: the autopilot plays as a guest
+        session->currentUser = nullptr;
+        session->demo = true;
+        return SESSION_PLAYING;
+    case 7: // Multiplayer
+        PlayArena();
+        break;
     }
+    return SESSION_MENU;
+}
 
-    // Game over
-    bool newHighScore = false;
-    if (currentUser != nullptr && game.score > currentUser->highScore) {
-        currentUser->highScore = game.score;
-        newHighScore = true;
-        UpdateLeaderboard(users, currentUser, game.score);
-        SaveUsers(users);
+// Play one game in the session's reused game state
+SessionState PlayGame(Session* session) {
+    GameState& game = session->game;
+    Renderer* renderer = screen;
+    Replay& replay = session->replay;
+    Autopilot* pilot = session->pilot;
+    bool demo = session->demo;
+
+    game.currentUser = session->currentUser;
+    string owner = (session->currentUser != nullptr) ? session->currentUser->username : "";
+    string savePath = SaveGamePath(owner);
+    if (session->resume) {
+        // The saved game was loaded by the menu and recording continues its
+        // replay; the file stays until the game is put aside again or finished
+        session->resume = false;
     }
+    else {
+        session->config.seed = NewSeed();
+        Setup(&game, session->config);
 
-    DrawGameOver(game.score, newHighScore);
+        // Every game is recorded so it can be played back with SnakeSim
+        StartRecording(&replay, session->config);
+    }
+    if (demo) InitAutopilot(pilot, game, HAMILTONIAN, 2000);
+
+    // Game loop: logic runs on a fixed timestep of game.speed milliseconds and
+    // the board is drawn once after each batch of due ticks
+    InputEvent stale;
+    while (keyQueue.Pop(&stale)) {}
+    inputRunning = true;
+    thread inputThread(ReadKeys);
+
+    // Demo games are never saved, and leave a guest's save alone
+    if (!demo) StartAutosave(savePath, owner, game, replay);
+    uint32_t nextAutosave = game.tick + AUTOSAVE_TICKS;
+
+    TickTimer timer;
+    StartTimer(&timer, game.speed);
+    DrawGame(game, &layers.game, gameInput.showHud ? &profiler : nullptr, renderer, console);
+    gameInput.quit = false;
+    while (!game.gameOver && !gameInput.quit) {
+        auto frameStart = chrono::steady_clock::now();
+        FrameSample sample = {};
+        {
+            ProfileScope scope(&profiler.metrics[METRIC_WAIT], &sample.waitNs);
+            WaitForTick(&timer);
+        }
+        int due = DueTicks(&timer);
+        for (int i = 0; i < due && !game.gameOver; i++) {
+            // X stops the loop between ticks, so a saved game resumes with this tick
+            if (!RunGameTick(&gameInput, &game, &replay, demo ? pilot : nullptr, &profiler, &sample)) break;
+        }
+        // Game speed. DueTicks has already scheduled past the whole batch, so a
+        // speed-up eaten mid-batch moves only the next deadline.
+        SetTimerPeriod(&timer, game.speed);
+        if (!demo && game.tick >= nextAutosave && !game.gameOver) {
+            QueueAutosave(game, replay);
+            nextAutosave = game.tick + AUTOSAVE_TICKS;
+        }
+        {
+            ProfileScope scope(&profiler.metrics[METRIC_DRAW], &sample.drawNs);
+            sample.bytes = DrawGame(game, &layers.game, gameInput.showHud ? &profiler : nullptr, renderer, console);
+        }
+        sample.tick = game.tick;
+        sample.frameNs = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - frameStart).count();
+        RecordFrame(&profiler, sample);
+    }
+    inputRunning = false;
+    inputThread.join();
+
+    // X puts the game aside: the player resumes it after logging in again. A
+    // game that ended has nothing left to resume, so its autosave goes.
+    session->saved = false;
+    if (!demo) {
+        StopAutosave();
+        if (gameInput.quit) session->saved = SaveGame(savePath, owner, game, replay);
+        else remove(savePath.c_str());
+    }
 
-    // Return to main menu
-    _getch();
-    main(); // Restart the program to show main menu again
+    FinishRecording(&replay, game);
+    SaveReplay(replay, "last.rpl");
 
-    return 0;
+    // A new high score is ranked at once and written in the background
+    session->newHighScore = false;
+    User* currentUser = session->currentUser;
+    if (currentUser != nullptr && game.score > currentUser->highScore) {
+        session->newHighScore = true;
+        UpdateLeaderboard(session->leaderboard, currentUser, game.score);
+        SaveUser(currentUser);
+    }
+    return SESSION_GAME_OVER;
 }
 
-// Utility function to set console text and background colors
-void SetConsoleColor(int textColor, int bgColor) {
-    HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-    SetConsoleTextAttribute(hConsole, (bgColor << 4) | textColor);
+// Show how the last game ended until a key is pressed
+SessionState ShowGameOver(Session* session) {
+    User* currentUser = session->currentUser;
+    size_t rank = (currentUser != nullptr) ? session->leaderboard.Rank(*currentUser) : 0;
+    DrawGameOver(session->game.score, session->newHighScore, session->game.won, session->saved, rank);
+    console->ReadKey(-1);
+    return SESSION_MENU;
 }
 
-// Utility function to center text in console
-void CenterText(const string& text, int width, int textColor, int bgColor) {
-    SetConsoleColor(textColor, bgColor);
-    int spaces = (width - text.length()) / 2;
-    cout << string(spaces, ' ') << text << string(spaces, ' ');
-    if ((width - text.length()) % 2 != 0) cout << " ";
-    SetConsoleColor(WHITE, BLACK);
-    cout << endl;
+// Ask whether to continue the game the player saved, if there is one; a yes
+// leaves it loaded into the session's game state and replay. Only the player's
+// own save file is read, and LoadGame() checks its owner before decoding.
+bool OfferResume(Session* session) {
+    string owner = (session->currentUser != nullptr) ? session->currentUser->username : "";
+    if (!LoadGame(SaveGamePath(owner), owner, &session->game, &session->replay)) return false;
+
+    char line[SCREEN_WIDTH + 1];
+    snprintf(line, sizeof(line), "Saved game at score %d: resume it (Y), or start a new one in its place (N)?", session->game.score);
+    ClearFrame(&screen->back);
+    PutCentered(&screen->back, SCREEN_HEIGHT / 2, line, YELLOW);
+    console->Show(screen);
+    int key = console->ReadKey(-1);
+    return key == 'y' || key == 'Y';
 }
 
-// Utility function to move cursor to specific coordinates
-void GotoXY(int x, int y) {
-    COORD coord;
-    coord.X = x;
-    coord.Y = y;
-    SetConsoleCursorPosition(GetStdHandle(STD_OUTPUT_HANDLE), coord);
+// Show a one-line message on a blank screen for a moment
+void ShowMessage(const string& text, int textColor) {
+    ClearFrame(&screen->back);
+    PutCentered(&screen->back, SCREEN_HEIGHT / 2, text, textColor);
+    console->Show(screen);
+    this_thread::sleep_for(chrono::milliseconds(1500));
 }
 
-// Utility function to hide the cursor
-void HideCursor() {
-    HANDLE consoleHandle = GetStdHandle(STD_OUTPUT_HANDLE);
-    CONSOLE_CURSOR_INFO info;
-    info.dwSize = 100;
-    info.bVisible = FALSE;
-    SetConsoleCursorInfo(consoleHandle, &info);
+// Compose the static screens, once for the whole session
+void BuildScreenLayers() {
+    BuildMainMenuLayer(&layers.mainMenu);
+    BuildLoginLayer(&layers.login);
+    BuildRegisterLayer(&layers.registerMenu);
+    BuildGameOverLayer(&layers.gameOver);
+    BuildLeaderboardLayer(&layers.leaderboard);
 }
 
-// Draw a box with borders
-void DrawBox(int x, int y, int width, int height, int textColor, int bgColor) {
-    SetConsoleColor(textColor, bgColor);
-
-    // Draw top border
-    GotoXY(x, y);
-    cout << WALL_CORNER_TL;
-    for (int i = 0; i < width - 2; i++) cout << WALL_HORIZONTAL;
-    cout << WALL_CORNER_TR;
-
-    // Draw side borders
-    for (int i = 1; i < height - 1; i++) {
-        GotoXY(x, y + i);
-        cout << WALL_VERTICAL;
-        GotoXY(x + width - 1, y + i);
-        cout << WALL_VERTICAL;
-    }
-
-    // Draw bottom border
-    GotoXY(x, y + height - 1);
-    cout << WALL_CORNER_BL;
-    for (int i = 0; i < width - 2; i++) cout << WALL_HORIZONTAL;
-    cout << WALL_CORNER_BR;
-
-    SetConsoleColor(WHITE, BLACK);
+// Put a static screen up as it is
+void ShowLayer(const Frame& layer) {
+    screen->back = layer;
+    console->Show(screen);
 }
 
-// Draw the main menu
-void DrawMainMenu() {
-    system("cls");
+// Main menu: the banner, the box and the options
+void BuildMainMenuLayer(Frame* frame) {
+    ClearFrame(frame);
 
     // Draw title
     int y = 3;
-    SetConsoleColor(YELLOW, BLACK);
-    GotoXY(28, y++);
-    cout << " _____ _   _    _    _  _______";
-    GotoXY(28, y++);
-    cout << "/  ___| \\ | |  / \\  | |/ / ____|";
-    GotoXY(28, y++);
-    cout << "\\ `--.|  \\| | / _ \\ | ' /|  _|  ";
-    GotoXY(28, y++);
-    cout << " `--. \\ . ` |/ ___ \\|  < | |___ ";
-    GotoXY(28, y++);
-    cout << "/\\__/ / |\\  / /   \\ \\ . \\|  ___|";
-    GotoXY(28, y++);
-    cout << "\\____/\\_| \\_\\/     \\_\\_|\\_\\_____|";
+    PutText(frame, 28, y++, " _____ _   _    _    _  _______", YELLOW);
+    PutText(frame, 28, y++, "/  ___| \\ | |  / \\  | |/ / ____|", YELLOW);
+    PutText(frame, 28, y++, "\\ `--.|  \\| | / _ \\ | ' /|  _|  ", YELLOW);
+    PutText(frame, 28, y++, " `--. \\ . ` |/ ___ \\|  < | |___ ", YELLOW);
+    PutText(frame, 28, y++, "/\\__/ / |\\  / /   \\ \\ . \\|  ___|", YELLOW);
+    PutText(frame, 28, y++, "\\____/\\_| \\_\\/     \\_\\_|\\_\\_____|", YELLOW);
     y += 2;
 
     // Draw menu box
-    DrawBox(25, y, 30, 10, CYAN, BLACK);
+    DrawBox(frame, 25, y, 30, 11, CYAN);
 
     // Draw menu options
-    SetConsoleColor(WHITE, BLACK);
-    GotoXY(35, y + 2);
-    cout << "1. Login";
-    GotoXY(35, y + 3);
-    cout << "2. Register";
-    GotoXY(35, y + 4);
-    cout << "3. Leaderboard";
-    GotoXY(35, y + 5);
-    cout << "4. Play as Guest";
-    GotoXY(35, y + 6);
-    cout << "5. Exit";
-
-    GotoXY(30, y + 8);
-    SetConsoleColor(LIGHTGRAY, BLACK);
-    cout << "Select an option (1-5): ";
+    PutText(frame, 35, y + 2, "1. Login", WHITE);
+    PutText(frame, 35, y + 3, "2. Register", WHITE);
+    PutText(frame, 35, y + 4, "3. Leaderboard", WHITE);
+    PutText(frame, 35, y + 5, "4. Play as Guest", WHITE);
+    PutText(frame, 35, y + 6, "5. Exit", WHITE);
+    PutText(frame, 35, y + 7, "6. Demo Mode", WHITE);
+    PutText(frame, 35, y + 8, "7. Multiplayer", WHITE);
+
+    PutText(frame, 30, y + 9, "Select an option (1-7): ", LIGHTGRAY);
 }
 
-// Draw login menu
-void DrawLoginMenu() {
-    system("cls");
+// Login menu, without the typed fields
+void BuildLoginLayer(Frame* frame) {
+    ClearFrame(frame);
 
     int y = 5;
-    SetConsoleColor(CYAN, BLACK);
-    GotoXY(33, y++);
-    cout << "LOGIN MENU";
+    PutText(frame, 33, y++, "LOGIN MENU", CYAN);
     y++;
 
-    DrawBox(25, y, 30, 8, BLUE, BLACK);
+    DrawBox(frame, 25, y, 30, 8, BLUE);
 
-    SetConsoleColor(WHITE, BLACK);
-    GotoXY(28, y + 2);
-    cout << "Username: ";
-
-    GotoXY(28, y + 4);
-    cout << "Password: ";
+    PutText(frame, 28, y + 2, "Username: ", WHITE);
+    PutText(frame, 28, y + 4, "Password: ", WHITE);
 }
 
-// Draw register menu
-void DrawRegisterMenu() {
-    system("cls");
+// Register menu, without the typed fields
+void BuildRegisterLayer(Frame* frame) {
+    ClearFrame(frame);
 
     int y = 5;
-    SetConsoleColor(GREEN, BLACK);
-    GotoXY(32, y++);
-    cout << "REGISTER MENU";
+    PutText(frame, 32, y++, "REGISTER MENU", GREEN);
     y++;
 
-    DrawBox(25, y, 30, 8, GREEN, BLACK);
-
-    SetConsoleColor(WHITE, BLACK);
-    GotoXY(28, y + 2);
-    cout << "New Username: ";
+    DrawBox(frame, 25, y, 30, 8, GREEN);
 
-    GotoXY(28, y + 4);
-    cout << "New Password: ";
+    PutText(frame, 28, y + 2, "New Username: ", WHITE);
+    PutText(frame, 28, y + 4, "New Password: ", WHITE);
 }
 
-// Draw game over screen
-void DrawGameOver(int score, bool newHighScore) {
-    system("cls");
+// Game over screen: the banner, the box and the prompt
+void BuildGameOverLayer(Frame* frame) {
+    ClearFrame(frame);
 
     int y = 5;
-    SetConsoleColor(LIGHTRED, BLACK);
-    GotoXY(26, y++);
-    cout << "  _____          __  __ ______    ______      ________ _____  ";
-    GotoXY(26, y++);
-    cout << " / ____|   /\\   |  \\/  |  ____|  / __ \\ \\    / /  ____|  __ \\ ";
-    GotoXY(26, y++);
-    cout << "| |  __   /  \\  | \\  / | |__    | |  | \\ \\  / /| |__  | |__) |";
-    GotoXY(26, y++);
-    cout << "| | |_ | / /\\ \\ | |\\/| |  __|   | |  | |\\ \\/ / |  __| |  _  / ";
-    GotoXY(26, y++);
-    cout << "| |__| |/ ____ \\| |  | | |____  | |__| | \\  /  | |____| | \\ \\ ";
-    GotoXY(26, y++);
-    cout << " \\_____/_/    \\_\\_|  |_|______|  \\____/   \\/   |______|_|  \\_\\";
-    y += 2;
-
-    DrawBox(25, y, 30, 7, YELLOW, BLACK);
-
-    SetConsoleColor(WHITE, BLACK);
-    GotoXY(28, y + 2);
-    cout << "Your Score: " << score;
-
-    if (newHighScore) {
-        GotoXY(28, y + 3);
-        SetConsoleColor(LIGHTGREEN, BLACK);
-        cout << "NEW HIGH SCORE!";
-        SetConsoleColor(WHITE, BLACK);
-    }
-
-    GotoXY(28, y + 5);
-    SetConsoleColor(LIGHTGRAY, BLACK);
-    cout << "Press any key to continue...";
+    PutText(frame, 26, y++, "  _____          __  __ ______    ______      ________ _____  ", LIGHTRED);
+    PutText(frame, 26, y++, " / ____|   /\\   |  \\/  |  ____|  / __ \\ \\    / /  ____|  __ \\ ", LIGHTRED);
+    PutText(frame, 26, y++, "| |  __   /  \\  | \\  / | |__    | |  | \\ \\  / /| |__  | |__) |", LIGHTRED);
+    PutText(frame, 26, y++, "| | |_ | / /\\ \\ | |\\/| |  __|   | |  | |\\ \\/ / |  __| |  _  / ", LIGHTRED);
+    PutText(frame, 26, y++, "| |__| |/ ____ \\| |  | | |____  | |__| | \\  /  | |____| | \\ \\ ", LIGHTRED);
+    PutText(frame, 26, y++, " \\_____/_/    \\_\\_|  |_|______|  \\____/   \\/   |______|_|  \\_\\", LIGHTRED);
+
+    DrawBox(frame, 25, GAME_OVER_BOX_Y, 30, 7, YELLOW);
+    PutText(frame, 28, GAME_OVER_BOX_Y + 5, "Press any key to continue...", LIGHTGRAY);
 }
 
-// Set up the initial game state
-void Setup(GameState* game) {
-    game->gameOver = false;
-    game->dir = STOP;
-    game->score = 0;
-    game->speed = 150; // Initial game speed
-
-    // Initialize snake with 3 segments
-    game->snake.clear();
-    SnakeSegment head;
-    head.x = WIDTH / 2;
-    head.y = HEIGHT / 2;
-    game->snake.push_back(head);
-
-    for (int i = 1; i < 3; i++) {
-        SnakeSegment segment;
-        segment.x = head.x - i;
-        segment.y = head.y;
-        game->snake.push_back(segment);
-    }
-
-    // Place food at random position
-    game->foodX = rand() % (WIDTH - 4) + 2;
-    game->foodY = rand() % (HEIGHT - 4) + 2;
+// Draw game over screen
+void DrawGameOver(int score, bool newHighScore, bool won, bool saved, size_t rank) {
+    Frame* frame = &screen->back;
+    *frame = layers.gameOver;
+
+    int y = GAME_OVER_BOX_Y;
+    char line[48];
+    if (rank > 0) snprintf(line, sizeof(line), "Your Score: %d  (Rank #%zu)", score, rank);
+    else snprintf(line, sizeof(line), "Your Score: %d", score);
+    PutText(frame, 28, y + 2, line, WHITE);
+
+    if (newHighScore) PutText(frame, 28, y + 3, "NEW HIGH SCORE!", LIGHTGREEN);
+    if (won) PutText(frame, 28, y + 4, "FOOD AREA FULL - YOU WIN!", YELLOW);
+    if (saved) PutText(frame, 28, y + 4, "GAME SAVED FOR LATER", LIGHTCYAN);
+    console->Show(screen);
 }
 
-// Draw the game board, snake, and food
-void Draw(const GameState& game) {
-    system("cls");
-
-    // Draw title and info
-    SetConsoleColor(YELLOW, BLACK);
-    CenterText("SNAKE GAME", 80);
-
-    string playerInfo = "Player: ";
-    playerInfo += (game.currentUser ? game.currentUser->username : "Guest");
-    playerInfo += " | Score: " + to_string(game.score);
-    if (game.currentUser) {
-        playerInfo += " | High Score: " + to_string(game.currentUser->highScore);
+// Input thread: stamps each key press and hands it to the game loop, so keys
+// pressed in quick succession within one tick are all kept
+void ReadKeys() {
+    while (inputRunning) {
+        int key = console->ReadKey(10);
+        if (key == KEY_NONE) continue;
+        InputEvent event;
+        event.key = key;
+        event.time = chrono::steady_clock::now();
+        keyQueue.Push(event);
     }
-
-    SetConsoleColor(CYAN, BLACK);
-    CenterText(playerInfo, 80);
-    cout << endl;
-
-    // Create a 2D array to represent the game board
-    char board[HEIGHT][WIDTH];
-
-    // Initialize the board with empty spaces
-    for (int y = 0; y < HEIGHT; y++) {
-        for (int x = 0; x < WIDTH; x++) {
-            if (y == 0 && x == 0)
-                board[y][x] = WALL_CORNER_TL;
-            else if (y == 0 && x == WIDTH - 1)
-                board[y][x] = WALL_CORNER_TR;
-            else if (y == HEIGHT - 1 && x == 0)
-                board[y][x] = WALL_CORNER_BL;
-            else if (y == HEIGHT - 1 && x == WIDTH - 1)
-                board[y][x] = WALL_CORNER_BR;
-            else if (y == 0 || y == HEIGHT - 1)
-                board[y][x] = WALL_HORIZONTAL;
-            else if (x == 0 || x == WIDTH - 1)
-                board[y][x] = WALL_VERTICAL;
-            else
-                board[y][x] = EMPTY;
-        }
-    }
-
-    // Add food to the board
-    board[game.foodY][game.foodX] = FOOD;
-
-    // Add snake to the board
-    for (size_t i = 0; i < game.snake.size(); i++) {
-        int x = game.snake[i].x;
-        int y = game.snake[i].y;
-        if (x >= 0 && x < WIDTH && y >= 0 && y < HEIGHT) {
-            board[y][x] = (i == 0) ? SNAKE_HEAD : SNAKE_BODY;
-        }
-    }
-
-    // Start the board at an offset to center it
-    int offsetX = (80 - WIDTH * 2) / 2;
-    int offsetY = 4;
-
-    // Draw the board with colors
-    for (int y = 0; y < HEIGHT; y++) {
-        GotoXY(offsetX, offsetY + y);
-        for (int x = 0; x < WIDTH; x++) {
-            if (board[y][x] == WALL_HORIZONTAL || board[y][x] == WALL_VERTICAL ||
-                board[y][x] == WALL_CORNER_TL || board[y][x] == WALL_CORNER_TR ||
-                board[y][x] == WALL_CORNER_BL || board[y][x] == WALL_CORNER_BR) {
-                SetConsoleColor(CYAN, BLACK);
-            }
-            else if (board[y][x] == SNAKE_HEAD) {
-                SetConsoleColor(LIGHTGREEN, BLACK);
-            }
-            else if (board[y][x] == SNAKE_BODY) {
-                SetConsoleColor(GREEN, BLACK);
-            }
-            else if (board[y][x] == FOOD) {
-                SetConsoleColor(LIGHTRED, BLACK);
-            }
-            else {
-                SetConsoleColor(WHITE, BLACK);
-            }
-
-            // Use double characters for better aspect ratio
-            cout << board[y][x] << " ";
-        }
-    }
-
-    // Draw controls at the bottom
-    GotoXY(offsetX, offsetY + HEIGHT + 1);
-    SetConsoleColor(WHITE, BLACK);
-    cout << "Controls: W (Up), A (Left), S (Down), D (Right), X (Quit)";
-
-    // Restore default color
-    SetConsoleColor(WHITE, BLACK);
 }
 
-// Process user input
-void Input(GameState* game) {
-    if (_kbhit()) {
-        switch (_getch()) {
-        case 'a':
-        case 'A':
-            if (game->dir != RIGHT) game->dir = LEFT;
-            break;
-        case 'd':
-        case 'D':
-            if (game->dir != LEFT) game->dir = RIGHT;
-            break;
-        case 'w':
-        case 'W':
-            if (game->dir != DOWN) game->dir = UP;
-            break;
-        case 's':
-        case 'S':
-            if (game->dir != UP) game->dir = DOWN;
-            break;
-        case 'x':
-        case 'X':
-            game->gameOver = true;
-            break;
-        }
-    }
+// Seed for a new game; the clock's full resolution keeps games started within
+// the same second apart
+uint64_t NewSeed() {
+    return static_cast<uint64_t>(chrono::system_clock::now().time_since_epoch().count());
 }
 
-// Update game logic
-void Logic(GameState* game) {
-    // If the game hasn't started yet, don't update
-    if (game->dir == STOP) return;
-
-    // Remember previous position of snake segments
-    vector<SnakeSegment> prevPositions = game->snake;
-
-    // Move the head
-    switch (game->dir) {
-    case LEFT:
-        game->snake[0].x--;
-        break;
-    case RIGHT:
-        game->snake[0].x++;
-        break;
-    case UP:
-        game->snake[0].y--;
-        break;
-    case DOWN:
-        game->snake[0].y++;
-        break;
-    default:
-        break;
-    }
-
-    // Move the rest of the snake
-    for (size_t i = 1; i < game->snake.size(); i++) {
-        game->snake[i] = prevPositions[i - 1];
-    }
-
-    // Check for collisions with walls
-    if (game->snake[0].x <= 0 || game->snake[0].x >= WIDTH - 1 ||
-        game->snake[0].y <= 0 || game->snake[0].y >= HEIGHT - 1) {
-        game->gameOver = true;
-        return;
-    }
-
-    // Check for collisions with self
-    for (size_t i = 1; i < game->snake.size(); i++) {
-        if (game->snake[0].x == game->snake[i].x && game->snake[0].y == game->snake[i].y) {
-            game->gameOver = true;
-            return;
-        }
-    }
-
-    // Check if food is eaten
-    if (game->snake[0].x == game->foodX && game->snake[0].y == game->foodY) {
-        // Increase score
-        game->score += 10;
-
-        // Add new segment to snake
-        SnakeSegment newSegment = game->snake.back();
-        game->snake.push_back(newSegment);
-
-        // Generate new food
-        bool validPosition;
-        do {
-            validPosition = true;
-            game->foodX = rand() % (WIDTH - 4) + 2;
-            game->foodY = rand() % (HEIGHT - 4) + 2;
-
-            // Make sure food doesn't spawn on snake
-            for (const auto& segment : game->snake) {
-                if (game->foodX == segment.x && game->foodY == segment.y) {
-                    validPosition = false;
+// Local multiplayer: player 1 steers with WASD and player 2 with IJKL, sharing the
+// board with bots until both players are dead or X is pressed
+void PlayArena() {
+    ArenaConfig config;
+    config.width = SCREEN_WIDTH / 2;
+    config.height = SCREEN_HEIGHT - 5;
+    config.snakes = ARENA_PLAYERS + ARENA_BOTS;
+    config.food = ARENA_FOOD_ITEMS;
+    config.seed = NewSeed();
+    Arena* arena = new Arena;
+    SetupArena(arena, config);
+    Rng botRng(config.seed);
+    botRng.Jump(); // a stream apart from the food and spawns
+
+    Renderer* renderer = screen;
+
+    InputEvent event;
+    while (keyQueue.Pop(&event)) {}
+    inputRunning = true;
+    thread inputThread(ReadKeys);
+
+    TickTimer timer;
+    StartTimer(&timer, ARENA_SPEED);
+    bool quit = false;
+    DrawArenaScreen(*arena, renderer);
+    while (!quit && (arena->snakes[0].alive || arena->snakes[1].alive)) {
+        WaitForTick(&timer);
+        int due = DueTicks(&timer);
+        for (int i = 0; i < due; i++) {
+            while (keyQueue.Pop(&event)) {
+                switch (event.key) {
+                case 'a':
+                case 'A':
+                    SteerSnake(arena, 0, LEFT);
+                    break;
+                case 'd':
+                case 'D':
+                    SteerSnake(arena, 0, RIGHT);
+                    break;
+                case 'w':
+                case 'W':
+                    SteerSnake(arena, 0, UP);
+                    break;
+                case 's':
+                case 'S':
+                    SteerSnake(arena, 0, DOWN);
+                    break;
+                case 'j':
+                case 'J':
+                    SteerSnake(arena, 1, LEFT);
+                    break;
+                case 'l':
+                case 'L':
+                    SteerSnake(arena, 1, RIGHT);
+                    break;
+                case 'i':
+                case 'I':
+                    SteerSnake(arena, 1, UP);
+                    break;
+                case 'k':
+                case 'K':
+                    SteerSnake(arena, 1, DOWN);
+                    break;
+                case 'x':
+                case 'X':
+                    quit = true;
                     break;
                 }
             }
-        } while (!validPosition);
-
-        // Increase game speed slightly with each food eaten (up to a limit)
-        if (game->speed > 50) {
-            game->speed -= 5;
+            for (int s = ARENA_PLAYERS; s < static_cast<int>(arena->snakes.size()); s++) {
+                if (arena->snakes[s].alive) SteerSnake(arena, s, ArenaBotMove(arena, s, &botRng));
+            }
+            ArenaTick(arena);
         }
+        DrawArenaScreen(*arena, renderer);
     }
+    inputRunning = false;
+    inputThread.join();
+
+    // Final scores
+    Frame* frame = &renderer->back;
+    ClearFrame(frame);
+    int y = 8;
+    DrawBox(frame, 25, y, 30, 7, YELLOW);
+    char line[32];
+    for (int p = 0; p < ARENA_PLAYERS; p++) {
+        snprintf(line, sizeof(line), "Player %d: %d", p + 1, arena->snakes[p].score);
+        PutText(frame, 28, y + 2 + p, line, ArenaColor(p));
+    }
+    PutText(frame, 28, y + 5, "Press any key to continue...", LIGHTGRAY);
+    console->Show(renderer);
+    delete arena;
+
+    console->ReadKey(-1);
 }
 
-// Handle user login
-bool Login(vector<User>& users, User** currentUser) {
-    string username, password;
-
-    DrawLoginMenu();
-
-    GotoXY(38, 9);
-    cin >> username;
-
-    GotoXY(38, 11);
-    // Simple masking of password
-    password = "";
-    char ch;
-    while ((ch = _getch()) != 13) { // 13 is Enter key
-        if (ch == 8) { // Backspace
-            if (!password.empty()) {
-                password.pop_back();
-                cout << "\b \b";
-            }
-        }
-        else {
-            password += ch;
-            cout << "*";
-        }
-    }
+// Draw the multiplayer board with both players' scores
+void DrawArenaScreen(const Arena& arena, Renderer* renderer) {
+    Frame* frame = &renderer->back;
+    ClearFrame(frame);
+
+    PutCentered(frame, 0, "SNAKE GAME - MULTIPLAYER", YELLOW);
+    char info[SCREEN_WIDTH + 1];
+    snprintf(info, sizeof(info), "P1: %d%s | P2: %d%s | Snakes: %d",
+        arena.snakes[0].score, arena.snakes[0].alive ? "" : " (out)",
+        arena.snakes[1].score, arena.snakes[1].alive ? "" : " (out)", arena.alive);
+    PutCentered(frame, 1, info, CYAN);
+
+    int offsetY = 3;
+    int viewWidth = min(arena.width, SCREEN_WIDTH / 2);
+    int viewHeight = min(arena.height, SCREEN_HEIGHT - offsetY - 2);
+    DrawArena(arena, frame, (SCREEN_WIDTH - viewWidth * 2) / 2, offsetY, viewWidth, viewHeight, -1);
+    PutCentered(frame, offsetY + viewHeight + 1, "P1: W A S D   P2: I J K L   X: Quit", WHITE);
+    console->Show(renderer);
+}
 
-    for (User& user : users) {
-        if (user.username == username && user.password == password) {
-            *currentUser = &user;
-            return true;
-        }
+// Handle user login
+bool Login(UserDirectory& users, User** currentUser) {
+    ShowLayer(layers.login);
+    string username = ReadLine(38, 9, false);
+    string password = ReadLine(38, 11, true); // Simple masking of password
+
+    User* user = users.Find(username);
+    if (user != nullptr && user->password == password) {
+        *currentUser = user;
+        return true;
     }
 
-    system("cls");
-    SetConsoleColor(LIGHTRED, BLACK);
-    CenterText("Invalid username or password.", 80);
-    SetConsoleColor(WHITE, BLACK);
-    Sleep(1500);
+    ShowMessage("Invalid username or password.", LIGHTRED);
     return false;
 }
 
 // Handle user registration
-bool Register(vector<User>& users) {
+bool Register(UserDirectory& users, User** registeredUser) {
     User newUser;
 
-    DrawRegisterMenu();
-
-    GotoXY(42, 9);
-    cin >> newUser.username;
+    ShowLayer(layers.registerMenu);
+    newUser.username = ReadLine(42, 9, false);
 
     // Check if username already exists
-    for (const User& user : users) {
-        if (user.username == newUser.username) {
-            system("cls");
-            SetConsoleColor(LIGHTRED, BLACK);
-            CenterText("Username already exists.", 80);
-            SetConsoleColor(WHITE, BLACK);
-            Sleep(1500);
-            return false;
-        }
-    }
-
-    GotoXY(42, 11);
-    // Simple masking of password
-    newUser.password = "";
-    char ch;
-    while ((ch = _getch()) != 13) { // 13 is Enter key
-        if (ch == 8) { // Backspace
-            if (!newUser.password.empty()) {
-                newUser.password.pop_back();
-                cout << "\b \b";
-            }
-        }
-        else {
-            newUser.password += ch;
-            cout << "*";
-        }
+    if (users.Find(newUser.username) != nullptr) {
+        ShowMessage("Username already exists.", LIGHTRED);
+        return false;
     }
 
+    newUser.password = ReadLine(42, 11, true); // Simple masking of password
     newUser.highScore = 0;
-    users.push_back(newUser);
+    newUser.record = NO_RECORD;
+    *registeredUser = users.Add(newUser);
 
     return true;
 }
 
-// Save users to file
-void SaveUsers(const vector<User>& users) {
-    ofstream file("users.txt");
-
-    if (!file.is_open()) {
-        system("cls");
-        SetConsoleColor(LIGHTRED, BLACK);
-        CenterText("Error opening file for saving users.", 80);
-        SetConsoleColor(WHITE, BLACK);
-        Sleep(1500);
-        return;
+// Read a line typed at (x, y) of the current screen, echoing each key or, when
+// masked, an asterisk. Input is capped at MAX_CREDENTIAL_LENGTH characters.
+// Names cannot be empty or hold spaces, as with the old whitespace-split users file.
+string ReadLine(int x, int y, bool masked) {
+    string text;
+    while (true) {
+        // The cursor, and a blank that clears the cell a deleted character left
+        string shown = masked ? string(text.length(), '*') : text;
+        shown += "_ ";
+        PutText(&screen->back, x, y, shown.c_str(), WHITE);
+        console->Show(screen);
+
+        int key = console->ReadKey(-1);
+        if (key == KEY_ENTER && (masked || !text.empty())) break;
+        if (key == KEY_BACKSPACE) {
+            if (!text.empty()) text.pop_back();
+        }
+        else if (key > (masked ? 31 : 32) && key < 127 && text.length() < MAX_CREDENTIAL_LENGTH) {
+            text += static_cast<char>(key);
+        }
     }
+    return text;
+}
 
-    for (const User& user : users) {
-        file << user.username << " " << user.password << " " << user.highScore << endl;
+// Queue a user's record for the saver thread
+void SaveUser(User* user) {
+    {
+        lock_guard<mutex> lock(saveMutex);
+        pendingSaves.push_back(SaveRequest{ user, user->highScore });
     }
-
-    file.close();
+    saveReady.notify_one();
 }
 
-// Load users from file
-vector<User> LoadUsers() {
-    vector<User> users;
-    ifstream file("users.txt");
+// Saver thread: writes queued records as they arrive, new users appended and
+// known users getting their high score updated, and the running game's
+// autosaves, until the session ends and the queue is empty
+void FlushUsers() {
+    vector<SaveRequest> batch;
+    AutosaveRequest written;
+    GameState saved;
+    saved.currentUser = nullptr;
+    unique_lock<mutex> lock(saveMutex);
+    while (true) {
+        saveReady.wait(lock, [] { return !pendingSaves.empty() || autosave.pending || saverStopping; });
+        if (pendingSaves.empty() && !autosave.pending) return;
+        batch.swap(pendingSaves);
+        unique_lock<mutex> fileLock(saveFileMutex, defer_lock);
+        if (autosave.pending) {
+            fileLock.lock();
+            written.path = autosave.path;
+            written.owner = autosave.owner;
+            written.replay = autosave.replay;
+            autosave.pending = false;
+        }
+        lock.unlock();
+
+        if (fileLock.owns_lock()) {
+            // Replays are deterministic, so playing the turns back rebuilds the
+            // game exactly, free-cell order and random state included
+            ReplayCursor cursor;
+            StartPlayback(written.replay, &saved, &cursor);
+            while (StepPlayback(written.replay, &saved, &cursor)) {}
+            if (!SaveGame(written.path, written.owner, saved, written.replay)) saveFailed = true;
+            fileLock.unlock();
+        }
 
-    if (!file.is_open()) {
-        return users; // Return empty vector if file doesn't exist
+        for (const SaveRequest& request : batch) {
+            ProfileScope scope(&profiler.metrics[METRIC_SAVE_USER]);
+            User stored;
+            stored.username = request.user->username;
+            stored.password = request.user->password;
+            stored.highScore = request.highScore;
+            stored.record = request.user->record;
+            bool saved = (stored.record == NO_RECORD) ? AppendUser(&userStore, &stored) : SaveHighScore(&userStore, stored);
+            request.user->record = stored.record;
+            if (!saved) saveFailed = true;
+        }
+        batch.clear();
+        lock.lock();
     }
+}
 
-    User user;
-    while (file >> user.username >> user.password >> user.highScore) {
-        users.push_back(user);
-    }
+// Copy the replay of a game about to start, before its first frame, with room
+// for as many turns as the live replay
+void StartAutosave(const string& path, const string& owner, const GameState& game, const Replay& replay) {
+    lock_guard<mutex> lock(saveMutex);
+    autosave.path = path;
+    autosave.owner = owner;
+    autosave.replay = replay;
+    autosave.replay.events.reserve(replay.events.capacity());
+    autosave.replay.ticks = game.tick;
+    autosave.pending = false;
+}
 
-    file.close();
-    return users;
+// Hand the game at its current tick to the saver thread, replacing an autosave
+// it has not got to yet: only the turns recorded since the last one are copied
+void QueueAutosave(const GameState& game, const Replay& replay) {
+    {
+        lock_guard<mutex> lock(saveMutex);
+        vector<ReplayEvent>& events = autosave.replay.events;
+        events.insert(events.end(), replay.events.begin() + events.size(), replay.events.end());
+        autosave.replay.ticks = game.tick;
+        autosave.pending = true;
+    }
+    saveReady.notify_one();
 }
 
-// Display leaderboard
-void DisplayLeaderboard(const vector<User>& users) {
-    system("cls");
+// Drop an autosave the saver has not taken and wait for one it is writing, so
+// the save file is left to the game that has just ended
+void StopAutosave() {
+    {
+        lock_guard<mutex> lock(saveMutex);
+        autosave.pending = false;
+    }
+    lock_guard<mutex> fileLock(saveFileMutex);
+}
 
-    int y = 3;
-    SetConsoleColor(YELLOW, BLACK);
-    GotoXY(32, y++);
-    cout << "LEADERBOARD";
-    y++;
+// Tell the player if the saver thread could not write a record
+void ReportSaveErrors() {
+    if (saveFailed.exchange(false)) ShowMessage("Error saving user data.", LIGHTRED);
+}
 
-    // Create a copy of users for sorting
-    vector<User> sortedUsers = users;
-
-    // Sort users by high score in descending order
-    sort(sortedUsers.begin(), sortedUsers.end(),
-        [](const User& a, const User& b) {
-            return a.highScore > b.highScore;
-        });
-
-    // Draw leaderboard box
-    DrawBox(20, y, 40, 15, CYAN, BLACK);
-
-    // Draw header
-    GotoXY(22, y + 1);
-    SetConsoleColor(LIGHTGREEN, BLACK);
-    cout << left << setw(5) << "Rank" << setw(20) << "Username" << "High Score";
-    SetConsoleColor(WHITE, BLACK);
-
-    // Draw separator
-    GotoXY(22, y + 2);
-    cout << string(36, '-');
-
-    // Draw entries
-    int rank = 1;
-    for (size_t i = 0; i < sortedUsers.size() && i < 10; i++) {
-        GotoXY(22, y + 3 + i);
-        if (i < 3) SetConsoleColor(YELLOW, BLACK); // Highlight top 3
-        else SetConsoleColor(WHITE, BLACK);
-
-        cout << left << setw(5) << rank++
-            << setw(20) << sortedUsers[i].username
-            << sortedUsers[i].highScore;
+// Load users from file and rank them by their stored high scores
+void LoadUsers(UserDirectory* users, Leaderboard* leaderboard) {
+    users->Clear();
+    leaderboard->Clear();
+    if (!userStore.file && !OpenUserStore(&userStore, "users.dat", "users.txt")) {
+        // Start with no users if the store cannot be opened, and say so
+        ShowMessage("Cannot open users.dat - accounts will not load or save.", LIGHTRED);
+        return;
     }
 
-    // If no users yet
-    if (sortedUsers.empty()) {
-        GotoXY(28, y + 7);
-        SetConsoleColor(LIGHTGRAY, BLACK);
-        cout << "No records yet!";
+    vector<User> stored;
+    ReadUsers(&userStore, &stored);
+    users->Reserve(stored.size());
+    for (const User& user : stored) {
+        User* added = users->Add(user);
+        if (added != nullptr) leaderboard->Insert(added);
     }
+}
 
-    // Footer
-    SetConsoleColor(WHITE, BLACK);
-    GotoXY(25, y + 13);
-    cout << "Press any key to return...";
+// Display leaderboard
+void DisplayLeaderboard(const Leaderboard& leaderboard) {
+    ComposeLeaderboard(leaderboard, layers.leaderboard, &screen->back);
+    console->Show(screen);
 
-    _getch();
+    console->ReadKey(-1);
 }
 
 // Update leaderboard with new score
-void UpdateLeaderboard(vector<User>& users, User* currentUser, int score) {
+void UpdateLeaderboard(Leaderboard& leaderboard, User* currentUser, int score) {
     if (score > currentUser->highScore) {
-        currentUser->highScore = score;
+        leaderboard.UpdateScore(currentUser, score);
     }
 }
\ No newline at end of file
@@ -0,0 +1,202 @@
+// Load generator for SnakeServer (Linux): many clients on one connection each
+//
+//   SnakeLoad <clients> [seconds] [port] [mirrors]
+//
+// Every client reads its frames and sends an occasional random turn. The first
+// `mirrors` clients also rebuild the board from the frames, checking each periodic
+// keyframe against the board their deltas produced.
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "NetProtocol.h"
+#include "Rng.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+const int DEFAULT_PORT = 7777;
+const int MAX_EVENTS = 256;
+
+// One turn is sent per this many deltas on average
+const int TURN_INTERVAL = 8;
+
+struct LoadClient {
+    int fd;
+    bool open;
+    bool mirrored;
+    std::vector<uint8_t> in;
+    ArenaMirror mirror;
+    long long deltas;
+    long long keyframes;
+    Clock::time_point lastDelta;
+};
+
+struct LoadStats {
+    long long frames;
+    long long bytes;
+    long long deltaBytes;
+    long long deltas;
+    long long keyframes;
+    long long malformed;
+    long long closed;
+    double maxGapMs; // longest wait between two deltas on one client
+};
+
+static void RaiseFileLimit() {
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+static int Connect(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+// Handle every complete frame in the client's input buffer
+static void ReadFrames(LoadClient* client, LoadStats* stats, Rng* rng) {
+    size_t offset = 0;
+    for (;;) {
+        uint32_t length = FrameLength(client->in.data() + offset, client->in.size() - offset);
+        if (client->in.size() - offset < FRAME_HEADER_SIZE) break;
+        if (length == 0 || length > MAX_FRAME_SIZE) {
+            stats->malformed++;
+            client->open = false;
+            break;
+        }
+        if (client->in.size() - offset < FRAME_HEADER_SIZE + length) break;
+
+        const uint8_t* frame = client->in.data() + offset + FRAME_HEADER_SIZE;
+        offset += FRAME_HEADER_SIZE + length;
+        stats->frames++;
+        if (client->mirrored && !ApplyFrame(&client->mirror, frame, length)) stats->malformed++;
+
+        if (frame[0] == MSG_KEYFRAME) {
+            stats->keyframes++;
+        }
+        else if (frame[0] == MSG_DELTA) {
+            Clock::time_point now = Clock::now();
+            if (client->deltas > 0) {
+                stats->maxGapMs = max(stats->maxGapMs, chrono::duration<double, milli>(now - client->lastDelta).count());
+            }
+            client->lastDelta = now;
+            client->deltas++;
+            stats->deltas++;
+            stats->deltaBytes += length;
+
+            if (rng->Below(TURN_INTERVAL) == 0) {
+                uint8_t turn = static_cast<uint8_t>(LEFT + rng->Below(4));
+                send(client->fd, &turn, 1, MSG_NOSIGNAL);
+            }
+        }
+    }
+    client->in.erase(client->in.begin(), client->in.begin() + offset);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: SnakeLoad <clients> [seconds] [port] [mirrors]\n");
+        return 2;
+    }
+    int count = atoi(argv[1]);
+    int seconds = argc > 2 ? atoi(argv[2]) : 10;
+    int port = argc > 3 ? atoi(argv[3]) : DEFAULT_PORT;
+    int mirrors = argc > 4 ? atoi(argv[4]) : 10;
+    RaiseFileLimit();
+
+    int epoll = epoll_create1(EPOLL_CLOEXEC);
+    vector<LoadClient> clients(count);
+    int connected = 0;
+    for (int i = 0; i < count; i++) {
+        LoadClient* client = &clients[i];
+        client->fd = Connect(port);
+        client->open = client->fd >= 0;
+        client->mirrored = i < mirrors;
+        client->deltas = 0;
+        client->keyframes = 0;
+        ResetMirror(&client->mirror);
+        if (!client->open) continue;
+
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.u32 = i;
+        epoll_ctl(epoll, EPOLL_CTL_ADD, client->fd, &event);
+        connected++;
+    }
+    printf("connected=%d of %d\n", connected, count);
+    fflush(stdout);
+
+    LoadStats stats = {};
+    Rng rng(1);
+    Clock::time_point start = Clock::now();
+    Clock::time_point end = start + chrono::seconds(seconds);
+    epoll_event events[MAX_EVENTS];
+    uint8_t buffer[65536];
+    while (Clock::now() < end) {
+        int ready = epoll_wait(epoll, events, MAX_EVENTS, 100);
+        for (int i = 0; i < ready; i++) {
+            LoadClient* client = &clients[events[i].data.u32];
+            if (!client->open) continue;
+            for (;;) {
+                ssize_t n = recv(client->fd, buffer, sizeof(buffer), 0);
+                if (n > 0) {
+                    stats.bytes += n;
+                    client->in.insert(client->in.end(), buffer, buffer + n);
+                    continue;
+                }
+                if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) client->open = false;
+                if (n < 0 && errno == EINTR) continue;
+                break;
+            }
+            ReadFrames(client, &stats, &rng);
+            if (!client->open) {
+                epoll_ctl(epoll, EPOLL_CTL_DEL, client->fd, nullptr);
+                stats.closed++;
+            }
+        }
+    }
+    double elapsed = chrono::duration<double>(Clock::now() - start).count();
+
+    long long mismatches = 0;
+    long long checked = 0;
+    for (LoadClient& client : clients) {
+        if (client.fd >= 0) close(client.fd);
+        if (client.mirrored) {
+            mismatches += client.mirror.keyframeMismatches;
+            checked += client.mirror.synced ? 1 : 0;
+        }
+    }
+    printf("clients=%d closed=%lld seconds=%.1f deltas_per_client_per_sec=%.1f max_gap_ms=%.1f in_mb_per_sec=%.2f "
+        "mean_delta_bytes=%.0f keyframes=%lld mirrors=%lld keyframe_mismatches=%lld malformed=%lld\n",
+        connected, stats.closed, elapsed, connected > 0 ? stats.deltas / (connected * elapsed) : 0.0, stats.maxGapMs,
+        stats.bytes / elapsed / 1e6, stats.deltas > 0 ? double(stats.deltaBytes) / stats.deltas : 0.0,
+        stats.keyframes, checked, mismatches, stats.malformed);
+    close(epoll);
+    return (connected == count && stats.closed == 0 && mismatches == 0 && stats.malformed == 0) ? 0 : 1;
+}
@@ -0,0 +1,352 @@
+// Authoritative multiplayer server (Linux): one arena with a snake per connected client
+//
+//   SnakeServer [port] [width] [height] [ticksPerSecond] [seconds]
+//
+// Clients send single Direction bytes. After every tick each client is sent the
+// cells that changed (MSG_DELTA); a client gets a keyframe when it joins and every
+// KEYFRAME_INTERVAL ticks. Runs until interrupted, or for the given number of seconds.
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "Arena.h"
+#include "NetProtocol.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+const int DEFAULT_PORT = 7777;
+const int KEYFRAME_INTERVAL = 100;
+const int RESPAWN_TICKS = 20;
+const int MAX_EVENTS = 256;
+
+// A client whose unsent output grows past this has fallen too far behind and is dropped
+const size_t MAX_PENDING_BYTES = 1 << 20;
+
+struct Client {
+    int fd;
+    int snake;
+    Direction turn; // last direction received since the previous tick
+    bool needKeyframe;
+    uint32_t deadSince; // tick the snake was found dead, 0 while it lives
+    bool writing; // waiting for EPOLLOUT
+    std::vector<uint8_t> out;
+    size_t sent;
+};
+
+struct Server {
+    int epoll;
+    int listener;
+    Arena arena;
+    std::vector<Client*> clients; // indexed by socket
+    int clientCount;
+    std::vector<int> freeSnakes; // snake slots of clients that left
+    std::vector<uint8_t> delta;
+    std::vector<uint8_t> keyframe;
+
+    // Statistics since the last report
+    long long bytesOut;
+    long long ticks;
+    double tickUsTotal;
+    double tickUsMax;
+    long long dropped;
+};
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void RequestStop(int) {
+    stopRequested = 1;
+}
+
+// Allow as many sockets as the hard limit permits
+static void RaiseFileLimit() {
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+static void WatchWrites(Server* server, Client* client, bool writing) {
+    if (client->writing == writing) return;
+    epoll_event event = {};
+    event.events = EPOLLIN | EPOLLRDHUP | (writing ? uint32_t(EPOLLOUT) : 0u);
+    event.data.fd = client->fd;
+    epoll_ctl(server->epoll, EPOLL_CTL_MOD, client->fd, &event);
+    client->writing = writing;
+}
+
+static void CloseClient(Server* server, Client* client) {
+    epoll_ctl(server->epoll, EPOLL_CTL_DEL, client->fd, nullptr);
+    close(client->fd);
+    RemoveSnake(&server->arena, client->snake);
+    server->freeSnakes.push_back(client->snake);
+    server->clients[client->fd] = nullptr;
+    server->clientCount--;
+    delete client;
+}
+
+// Write as much pending output as the socket takes; returns false if the client is gone
+static bool Flush(Server* server, Client* client) {
+    while (client->sent < client->out.size()) {
+        ssize_t n = send(client->fd, client->out.data() + client->sent, client->out.size() - client->sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            client->sent += n;
+            server->bytesOut += n;
+        }
+        else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            WatchWrites(server, client, true);
+            return true;
+        }
+        else if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        else {
+            return false;
+        }
+    }
+    client->out.clear();
+    client->sent = 0;
+    WatchWrites(server, client, false);
+    return true;
+}
+
+// Queue a frame for a client; returns false if it has fallen too far behind
+static bool Queue(Client* client, const vector<uint8_t>& frame) {
+    if (client->out.size() - client->sent + frame.size() > MAX_PENDING_BYTES) return false;
+    if (client->sent > 0 && client->sent * 2 > client->out.size()) {
+        client->out.erase(client->out.begin(), client->out.begin() + client->sent);
+        client->sent = 0;
+    }
+    client->out.insert(client->out.end(), frame.begin(), frame.end());
+    return true;
+}
+
+static void AcceptClients(Server* server) {
+    for (;;) {
+        int fd = accept4(server->listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        if (epoll_ctl(server->epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            continue;
+        }
+
+        Client* client = new Client;
+        client->fd = fd;
+        client->turn = STOP;
+        client->needKeyframe = true;
+        client->writing = false;
+        client->sent = 0;
+        if (!server->freeSnakes.empty()) {
+            client->snake = server->freeSnakes.back();
+            server->freeSnakes.pop_back();
+        }
+        else {
+            client->snake = static_cast<int>(server->arena.snakes.size());
+        }
+        client->deadSince = SpawnSnake(&server->arena, client->snake) ? 0 : max(server->arena.tick, 1u);
+
+        if (static_cast<size_t>(fd) >= server->clients.size()) server->clients.resize(fd + 1, nullptr);
+        server->clients[fd] = client;
+        server->clientCount++;
+
+        vector<uint8_t> welcome;
+        EncodeWelcome(server->arena, client->snake, &welcome);
+        Queue(client, welcome);
+        if (!Flush(server, client)) CloseClient(server, client);
+    }
+}
+
+// Take the turns a client sent; returns false once it has disconnected
+static bool ReadClient(Client* client) {
+    uint8_t buffer[256];
+    for (;;) {
+        ssize_t n = recv(client->fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            for (ssize_t i = 0; i < n; i++) {
+                if (buffer[i] >= LEFT && buffer[i] <= DOWN) client->turn = static_cast<Direction>(buffer[i]);
+            }
+        }
+        else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;
+        }
+        else if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        else {
+            return false;
+        }
+    }
+}
+
+static void Tick(Server* server) {
+    Arena* arena = &server->arena;
+    for (Client* client : server->clients) {
+        if (client == nullptr || client->turn == STOP) continue;
+        if (arena->snakes[client->snake].alive) SteerSnake(arena, client->snake, client->turn);
+        client->turn = STOP;
+    }
+    ArenaTick(arena);
+
+    // Dead players come back after a short wait
+    bool periodic = (arena->tick % KEYFRAME_INTERVAL == 0);
+    bool anyJoined = periodic;
+    for (Client* client : server->clients) {
+        if (client == nullptr) continue;
+        anyJoined = anyJoined || client->needKeyframe;
+        if (arena->snakes[client->snake].alive) continue;
+        if (client->deadSince == 0) client->deadSince = arena->tick;
+        if (arena->tick - client->deadSince >= RESPAWN_TICKS && SpawnSnake(arena, client->snake)) client->deadSince = 0;
+    }
+
+    // Each frame is encoded once and copied to every client
+    server->delta.clear();
+    EncodeDelta(*arena, &server->delta);
+    arena->changes.clear();
+    server->keyframe.clear();
+    if (anyJoined) EncodeKeyframe(*arena, &server->keyframe);
+
+    for (Client* client : server->clients) {
+        if (client == nullptr) continue;
+        bool ok;
+        if (client->needKeyframe) {
+            ok = Queue(client, server->keyframe);
+            client->needKeyframe = false;
+        }
+        else {
+            ok = Queue(client, server->delta) && (!periodic || Queue(client, server->keyframe));
+        }
+        if (!ok) server->dropped++;
+        if (!ok || !Flush(server, client)) CloseClient(server, client);
+    }
+}
+
+static int OpenListener(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char** argv) {
+    int port = argc > 1 ? atoi(argv[1]) : DEFAULT_PORT;
+    ArenaConfig config;
+    config.width = argc > 2 ? atoi(argv[2]) : 200;
+    config.height = argc > 3 ? atoi(argv[3]) : 200;
+    int ticksPerSecond = max(1, argc > 4 ? atoi(argv[4]) : 20);
+    int seconds = argc > 5 ? atoi(argv[5]) : 0;
+    config.snakes = 0;
+    config.food = config.width * config.height / 100;
+    config.seed = 1;
+
+    RaiseFileLimit();
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, RequestStop);
+    signal(SIGTERM, RequestStop);
+
+    Server* server = new Server;
+    SetupArena(&server->arena, config);
+    server->arena.logChanges = true;
+    server->clientCount = 0;
+    server->bytesOut = 0;
+    server->ticks = 0;
+    server->tickUsTotal = 0;
+    server->tickUsMax = 0;
+    server->dropped = 0;
+
+    server->listener = OpenListener(port);
+    server->epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (server->listener < 0 || server->epoll < 0) {
+        fprintf(stderr, "cannot listen on port %d\n", port);
+        return 1;
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = server->listener;
+    epoll_ctl(server->epoll, EPOLL_CTL_ADD, server->listener, &event);
+    printf("listening port=%d board=%dx%d ticks_per_sec=%d\n", port, server->arena.width, server->arena.height, ticksPerSecond);
+    fflush(stdout);
+
+    Clock::duration period = chrono::microseconds(1000000 / ticksPerSecond);
+    Clock::time_point start = Clock::now();
+    Clock::time_point nextTick = start + period;
+    Clock::time_point nextReport = start + chrono::seconds(1);
+    epoll_event events[MAX_EVENTS];
+    while (!stopRequested && (seconds == 0 || Clock::now() - start < chrono::seconds(seconds))) {
+        long long waitMs = chrono::duration_cast<chrono::milliseconds>(nextTick - Clock::now()).count();
+        int count = epoll_wait(server->epoll, events, MAX_EVENTS, static_cast<int>(max(0LL, waitMs)));
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+            if (fd == server->listener) {
+                AcceptClients(server);
+                continue;
+            }
+            Client* client = server->clients[fd];
+            if (client == nullptr) continue;
+            bool alive = !(events[i].events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP));
+            if (alive && (events[i].events & EPOLLIN)) alive = ReadClient(client);
+            if (alive && (events[i].events & EPOLLOUT)) alive = Flush(server, client);
+            if (!alive) CloseClient(server, client);
+        }
+
+        Clock::time_point now = Clock::now();
+        if (now >= nextTick) {
+            Tick(server);
+            double us = chrono::duration<double, micro>(Clock::now() - now).count();
+            server->ticks++;
+            server->tickUsTotal += us;
+            server->tickUsMax = max(server->tickUsMax, us);
+
+            // After a long stall start afresh rather than running a burst of ticks
+            nextTick += period;
+            if (now - nextTick > period * 5) nextTick = now + period;
+        }
+
+        if (now >= nextReport) {
+            printf("tick=%u clients=%d ticks=%lld tick_us_mean=%.0f tick_us_max=%.0f out_mb_per_sec=%.2f dropped=%lld\n",
+                server->arena.tick, server->clientCount, server->ticks,
+                server->ticks > 0 ? server->tickUsTotal / server->ticks : 0.0, server->tickUsMax,
+                server->bytesOut / 1e6, server->dropped);
+            fflush(stdout);
+            server->bytesOut = 0;
+            server->ticks = 0;
+            server->tickUsTotal = 0;
+            server->tickUsMax = 0;
+            nextReport += chrono::seconds(1);
+        }
+    }
+
+    for (Client* client : server->clients) {
+        if (client != nullptr) CloseClient(server, client);
+    }
+    close(server->listener);
+    close(server->epoll);
+    delete server;
+    return 0;
+}
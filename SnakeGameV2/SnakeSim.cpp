@@ -0,0 +1,642 @@
+// Headless simulator: records, checks and plays back replays
+//
+//   SnakeSim record <count> <prefix> [seed] [width] [height]
+//   SnakeSim check <replay>...
+//   SnakeSim play <replay> [msPerTick]
+//   SnakeSim seek <replay> [interval] [keyframes]
+//   SnakeSim auto <bfs|astar|hamiltonian> <games> [budgetUs] [width] [height]
+//   SnakeSim arena <snakes> <ticks> [width] [height] [food] [msPerTick]
+//   SnakeSim batch <bfs|astar|hamiltonian> <games> <results.csv> [threads] [seed] [budgetUs] [width] [height]
+//   SnakeSim verify <games> [seed]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include "Arena.h"
+#include "Autopilot.h"
+#include "BatchRunner.h"
+#include "Console.h"
+#include "Renderer.h"
+#include "Replay.h"
+#include "Snapshot.h"
+
+using namespace std;
+
+// Replay viewer: a keyframe every 32 ticks, the latest 512 kept, so B can step
+// back REWIND_TICKS by re-simulating at most 32 ticks anywhere in the last 16k.
+// Snapshots grow with the board (a 200x200 one is near 100 KB), so big boards
+// keep fewer keyframes, within VIEWER_KEYFRAME_BYTES.
+const uint32_t VIEWER_KEYFRAME_INTERVAL = 32;
+const size_t VIEWER_KEYFRAMES = 512;
+const size_t VIEWER_MIN_KEYFRAMES = 16;
+const size_t VIEWER_KEYFRAME_BYTES = 16 << 20;
+const uint32_t REWIND_TICKS = 50;
+const int END_WAIT_MS = 3000; // time left to rewind once the replay ends
+
+// Recording bot: mostly heads for the food, sometimes turns at random
+Direction BotMove(const GameState& game, Rng* rng) {
+    if (rng->Below(5) == 0) return static_cast<Direction>(LEFT + rng->Below(4));
+    int dx = game.foodX - game.snake[0].x;
+    int dy = game.foodY - game.snake[0].y;
+    if (dx != 0 && (dy == 0 || rng->Below(2) == 0)) return dx < 0 ? LEFT : RIGHT;
+    return dy < 0 ? UP : DOWN;
+}
+
+int RecordGames(int count, const string& prefix, uint64_t seed, int width, int height) {
+    // The bot draws from its own stream so its moves do not follow the food
+    Rng rng(seed);
+    rng.Jump();
+    GameState game;
+    game.currentUser = nullptr;
+    Replay replay;
+    size_t bytes = 0;
+    for (int i = 0; i < count; i++) {
+        GameConfig config;
+        config.width = width;
+        config.height = height;
+        config.seed = seed + i;
+        Setup(&game, config);
+        StartRecording(&replay, config);
+        while (!game.gameOver) {
+            Direction dir = BotMove(game, &rng);
+            if (QueueTurn(&game, dir)) RecordTurn(&replay, game, dir);
+            Logic(&game);
+        }
+        FinishRecording(&replay, game);
+
+        vector<uint8_t> encoded;
+        EncodeReplay(replay, &encoded);
+        bytes += encoded.size();
+        if (!SaveReplay(replay, prefix + to_string(i) + ".rpl")) {
+            fprintf(stderr, "cannot write %s%d.rpl\n", prefix.c_str(), i);
+            return 1;
+        }
+    }
+    printf("recorded=%d bytes=%zu\n", count, bytes);
+    return 0;
+}
+
+int CheckReplays(int count, char** paths) {
+    GameState game;
+    game.currentUser = nullptr;
+    Replay replay;
+    int failed = 0;
+    long long ticks = 0;
+    double seconds = 0;
+    for (int i = 0; i < count; i++) {
+        if (!LoadReplay(&replay, paths[i])) {
+            printf("%s: unreadable\n", paths[i]);
+            failed++;
+            continue;
+        }
+        auto start = chrono::steady_clock::now();
+        bool same = PlayReplay(replay, &game);
+        seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        ticks += game.tick;
+        if (!same) {
+            printf("%s: MISMATCH score %d (recorded %d) length %zu (recorded %u)\n", paths[i],
+                game.score, replay.finalScore, game.snake.size(), replay.finalLength);
+            failed++;
+        }
+    }
+    printf("replays=%d failed=%d ticks=%lld ticks_per_sec=%.0f\n", count, failed, ticks,
+        seconds > 0 ? ticks / seconds : 0.0);
+    return failed == 0 ? 0 : 1;
+}
+
+// Show a replay in the console. Space pauses, B rewinds and F skips ahead
+// REWIND_TICKS, Q quits.
+int PlayRendered(const char* path, int msPerTick) {
+    Replay replay;
+    if (!LoadReplay(&replay, path)) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return 1;
+    }
+
+    GameState game;
+    game.currentUser = nullptr;
+    ReplayCursor cursor;
+    StartPlayback(replay, &game, &cursor);
+
+    // The first snapshot is about the largest, as the free-cell list only shrinks
+    vector<uint8_t> first;
+    EncodeSnapshot(game, &first);
+    KeyframeRing keyframes;
+    InitKeyframes(&keyframes, VIEWER_KEYFRAME_INTERVAL,
+        max(VIEWER_MIN_KEYFRAMES, min(VIEWER_KEYFRAMES, VIEWER_KEYFRAME_BYTES / first.size())));
+    TakeKeyframe(&keyframes, game);
+
+    Console* console = CreateConsole();
+    console->Open("Snake Replay");
+    Renderer* renderer = new Renderer;
+    ResetRenderer(renderer);
+    bool paused = false;
+    bool running = true;
+    while (running) {
+        bool ended = game.gameOver || game.tick >= replay.ticks;
+        char line[SCREEN_WIDTH + 1];
+        ClearFrame(&renderer->back);
+        snprintf(line, sizeof(line), "REPLAY  Tick: %u / %u  Score: %d%s", game.tick, replay.ticks, game.score,
+            paused ? "  (paused)" : ended ? "  (end)" : "");
+        PutCentered(&renderer->back, 1, line, CYAN);
+        int viewWidth = min(game.width, SCREEN_WIDTH / 2);
+        int viewHeight = min(game.height, SCREEN_HEIGHT - 5);
+        DrawBoard(game, &renderer->back, (SCREEN_WIDTH - viewWidth * 2) / 2, 3, viewWidth, viewHeight);
+        PutCentered(&renderer->back, SCREEN_HEIGHT - 1, "Space: Pause   B: Back   F: Forward   Q: Quit", WHITE);
+        console->Show(renderer);
+
+        int key = console->ReadKey(paused ? -1 : ended ? END_WAIT_MS : msPerTick);
+        switch (key) {
+        case ' ':
+            paused = !paused;
+            break;
+        case 'b':
+        case 'B':
+            SeekReplay(replay, keyframes, game.tick > REWIND_TICKS ? game.tick - REWIND_TICKS : 0, &game, &cursor);
+            break;
+        case 'f':
+        case 'F':
+            for (uint32_t i = 0; i < REWIND_TICKS && StepPlayback(replay, &game, &cursor); i++) {
+                TakeKeyframe(&keyframes, game);
+            }
+            break;
+        case 'q':
+        case 'Q':
+        case KEY_ESCAPE:
+            running = false;
+            break;
+        case KEY_NONE:
+            if (ended) running = false;
+            else if (!paused && StepPlayback(replay, &game, &cursor)) TakeKeyframe(&keyframes, game);
+            break;
+        }
+    }
+    console->Close();
+    delete console;
+    delete renderer;
+    printf("replay=%s tick=%u score=%d\n", path, game.tick, game.score);
+    return 0;
+}
+
+// Check that seeking a replay through keyframes gives exactly the state straight
+// playback reaches, at ticks spread over the whole game, and time the seeks
+int SeekReplayCheck(const char* path, uint32_t interval, size_t capacity) {
+    Replay replay;
+    if (!LoadReplay(&replay, path)) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return 1;
+    }
+
+    // Up to 1000 target ticks, and the snapshot straight playback gives at each
+    vector<uint32_t> targets;
+    uint32_t stride = max<uint32_t>(1, replay.ticks / 1000);
+    for (uint32_t tick = 0; tick <= replay.ticks; tick += stride) targets.push_back(tick);
+    vector<vector<uint8_t>> expected(targets.size());
+
+    GameState game;
+    game.currentUser = nullptr;
+    ReplayCursor cursor;
+    KeyframeRing keyframes;
+    InitKeyframes(&keyframes, interval, capacity);
+    StartPlayback(replay, &game, &cursor);
+    size_t next = 0;
+    while (true) {
+        TakeKeyframe(&keyframes, game);
+        while (next < targets.size() && targets[next] == game.tick) EncodeSnapshot(game, &expected[next++]);
+        if (!StepPlayback(replay, &game, &cursor)) break;
+    }
+    targets.resize(next);
+
+    // Seek in a scrambled order so every seek starts somewhere else
+    size_t keyframeBytes = 0;
+    for (size_t i = 0; i < keyframes.count; i++) keyframeBytes += keyframes.frames[(keyframes.first + i) % keyframes.frames.size()].size();
+    Rng rng(1);
+    vector<size_t> order(targets.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    shuffle(order.begin(), order.end(), rng);
+
+    int mismatches = 0;
+    double totalUs = 0;
+    double maxUs = 0;
+    vector<uint8_t> actual;
+    for (size_t i : order) {
+        auto start = chrono::steady_clock::now();
+        bool reached = SeekReplay(replay, keyframes, targets[i], &game, &cursor);
+        double us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+        totalUs += us;
+        maxUs = max(maxUs, us);
+        EncodeSnapshot(game, &actual);
+        if (!reached || actual != expected[i]) mismatches++;
+    }
+
+    printf("ticks=%u seeks=%zu mismatches=%d keyframes=%zu keyframe_bytes=%zu snapshot_bytes=%zu seek_mean_us=%.1f seek_max_us=%.1f\n",
+        replay.ticks, order.size(), mismatches, keyframes.count, keyframeBytes, expected.empty() ? 0 : expected.back().size(),
+        order.empty() ? 0.0 : totalUs / order.size(), maxUs);
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Let the autopilot play seeded games and report how well and how fast it moves
+int RunAutopilot(AutopilotStrategy strategy, int games, int budgetUs, int width, int height) {
+    GameState game;
+    game.currentUser = nullptr;
+    Autopilot pilot;
+    long long moves = 0;
+    long long overBudget = 0;
+    long long totalScore = 0;
+    int wins = 0;
+    double maxUs = 0;
+    double seconds = 0;
+    for (int i = 0; i < games; i++) {
+        GameConfig config;
+        config.width = width;
+        config.height = height;
+        config.seed = i + 1;
+        Setup(&game, config);
+        InitAutopilot(&pilot, game, strategy, budgetUs);
+
+        // Stop games that go on far longer than filling the board could take
+        uint32_t tickLimit = static_cast<uint32_t>(game.width) * game.height * 64;
+        auto start = chrono::steady_clock::now();
+        while (!game.gameOver && game.tick < tickLimit) {
+            QueueTurn(&game, ChooseMove(&pilot, game));
+            Logic(&game);
+        }
+        seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        moves += pilot.moves;
+        overBudget += pilot.overBudget;
+        totalScore += game.score;
+        maxUs = max(maxUs, pilot.maxUs);
+        if (game.won) wins++;
+    }
+    printf("strategy=%s games=%d wins=%d avg_score=%.1f moves=%lld moves_per_sec=%.0f over_budget=%lld max_move_us=%.1f\n",
+        StrategyName(strategy), games, wins, games > 0 ? double(totalScore) / games : 0.0, moves,
+        seconds > 0 ? moves / seconds : 0.0, overBudget, maxUs);
+    return 0;
+}
+
+// Let bots play on a shared board, respawning the dead, and report the tick rate.
+// With msPerTick above zero the board is drawn to stdout following snake 0.
+int RunArena(int snakes, int ticks, int width, int height, int food, int msPerTick) {
+    ArenaConfig config;
+    config.width = width;
+    config.height = height;
+    config.snakes = snakes;
+    config.food = food;
+    config.seed = 1;
+    Arena* arena = new Arena;
+    SetupArena(arena, config);
+
+    Renderer* renderer = nullptr;
+    if (msPerTick > 0) {
+        renderer = new Renderer;
+        ResetRenderer(renderer);
+#ifndef _WIN32
+        renderer->utf8 = true;
+#endif
+    }
+
+    Rng rng(5);
+    long long moves = 0;
+    long long deaths = 0;
+    double seconds = 0;
+    for (int t = 0; t < ticks; t++) {
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < static_cast<int>(arena->snakes.size()); i++) {
+            if (arena->snakes[i].alive) SteerSnake(arena, i, ArenaBotMove(arena, i, &rng));
+        }
+        moves += arena->alive;
+        ArenaTick(arena);
+        deaths += snakes - arena->alive;
+        for (int i = 0; i < static_cast<int>(arena->snakes.size()); i++) {
+            if (!arena->snakes[i].alive) SpawnSnake(arena, i);
+        }
+        seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        if (renderer != nullptr) {
+            ClearFrame(&renderer->back);
+            PutCentered(&renderer->back, 1, "ARENA  Tick: " + to_string(arena->tick) + "  Alive: " + to_string(arena->alive), CYAN);
+            int viewWidth = min(arena->width, SCREEN_WIDTH / 2);
+            int viewHeight = min(arena->height, SCREEN_HEIGHT - 5);
+            DrawArena(*arena, &renderer->back, (SCREEN_WIDTH - viewWidth * 2) / 2, 3, viewWidth, viewHeight, 0);
+            size_t bytes = Present(renderer);
+            fwrite(renderer->out.data(), 1, bytes, stdout);
+            fflush(stdout);
+            this_thread::sleep_for(chrono::milliseconds(msPerTick));
+        }
+    }
+    if (renderer != nullptr) printf("\x1b[0m\x1b[%d;1H", SCREEN_HEIGHT);
+
+    printf("board=%dx%d snakes=%d ticks=%d deaths=%lld ticks_per_sec=%.0f snake_moves_per_sec=%.0f ns_per_snake_move=%.1f\n",
+        arena->width, arena->height, snakes, ticks, deaths, seconds > 0 ? ticks / seconds : 0.0,
+        seconds > 0 ? moves / seconds : 0.0, moves > 0 ? seconds * 1e9 / moves : 0.0);
+    delete renderer;
+    delete arena;
+    return 0;
+}
+
+// Play a batch of seeded games on every core and write one result line per game
+int RunBatchGames(const BatchConfig& config, const char* path) {
+    vector<GameResult> results;
+    BatchStats stats;
+    RunBatch(config, &results, &stats);
+    if (!SaveResults(results, path)) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return 1;
+    }
+
+    long long totalScore = 0;
+    int wins = 0;
+    for (const GameResult& result : results) {
+        totalScore += result.score;
+        if (result.won) wins++;
+    }
+    printf("strategy=%s games=%d threads=%d wins=%d avg_score=%.1f ticks=%lld steals=%lld seconds=%.2f games_per_sec=%.1f ticks_per_sec=%.0f\n",
+        StrategyName(config.strategy), config.games, stats.threads, wins,
+        config.games > 0 ? double(totalScore) / config.games : 0.0, stats.ticks, stats.steals, stats.seconds,
+        stats.seconds > 0 ? config.games / stats.seconds : 0.0, stats.seconds > 0 ? stats.ticks / stats.seconds : 0.0);
+    return 0;
+}
+
+// Reference for `verify`: the engine as it was before the ring buffer, bitboard
+// and free list. The body is a plain vector, copied and shifted every tick, and
+// eating appends a copy of the tail. Food positions are taken from the engine
+// under test, since they follow the free list's order, and checked to be legal.
+struct ReferenceGame {
+    int width, height;
+    bool gameOver;
+    bool won;
+    int score;
+    int speed;
+    Direction dir;
+    vector<SnakeSegment> snake;
+    int foodX, foodY;
+};
+
+static bool IsReferenceFoodCell(const ReferenceGame& ref, int x, int y) {
+    return x >= 2 && x < ref.width - 2 && y >= 2 && y < ref.height - 2;
+}
+
+// Cells the reference body covers, one entry per board cell
+static void ReferenceCovered(const ReferenceGame& ref, vector<char>* covered) {
+    covered->assign(static_cast<size_t>(ref.width) * ref.height, 0);
+    for (const SnakeSegment& segment : ref.snake) (*covered)[segment.y * ref.width + segment.x] = 1;
+}
+
+void ReferenceSetup(ReferenceGame* ref, const GameState& game) {
+    ref->width = game.width;
+    ref->height = game.height;
+    ref->gameOver = false;
+    ref->won = false;
+    ref->score = 0;
+    ref->speed = 150;
+    ref->dir = STOP;
+    ref->snake.clear();
+    for (int i = 0; i < 3; i++) ref->snake.push_back(SnakeSegment{ game.width / 2 - i, game.height / 2 });
+    ref->foodX = game.foodX;
+    ref->foodY = game.foodY;
+}
+
+void ReferenceTurn(ReferenceGame* ref, Direction dir) {
+    switch (dir) {
+    case LEFT:
+        if (ref->dir != RIGHT) ref->dir = LEFT;
+        break;
+    case RIGHT:
+        if (ref->dir != LEFT) ref->dir = RIGHT;
+        break;
+    case UP:
+        if (ref->dir != DOWN) ref->dir = UP;
+        break;
+    case DOWN:
+        if (ref->dir != UP) ref->dir = DOWN;
+        break;
+    default:
+        break;
+    }
+}
+
+// One tick of the old Logic(); new food is the engine's, and false means it is
+// not a cell the old placement could have picked
+bool ReferenceLogic(ReferenceGame* ref, const GameState& engine) {
+    if (ref->dir == STOP) return true;
+
+    vector<SnakeSegment> prevPositions = ref->snake;
+    switch (ref->dir) {
+    case LEFT:
+        ref->snake[0].x--;
+        break;
+    case RIGHT:
+        ref->snake[0].x++;
+        break;
+    case UP:
+        ref->snake[0].y--;
+        break;
+    case DOWN:
+        ref->snake[0].y++;
+        break;
+    default:
+        break;
+    }
+    for (size_t i = 1; i < ref->snake.size(); i++) {
+        ref->snake[i] = prevPositions[i - 1];
+    }
+
+    const SnakeSegment head = ref->snake[0];
+    if (head.x <= 0 || head.x >= ref->width - 1 || head.y <= 0 || head.y >= ref->height - 1) {
+        ref->gameOver = true;
+        return true;
+    }
+    for (size_t i = 1; i < ref->snake.size(); i++) {
+        if (head.x == ref->snake[i].x && head.y == ref->snake[i].y) {
+            ref->gameOver = true;
+            return true;
+        }
+    }
+
+    if (head.x == ref->foodX && head.y == ref->foodY) {
+        ref->score += 10;
+        ref->snake.push_back(ref->snake.back());
+
+        // The old placement drew cells until one was off the snake, which never
+        // ends once the food area is covered: that is the win
+        vector<char> covered;
+        ReferenceCovered(*ref, &covered);
+        bool open = false;
+        for (int y = 2; y < ref->height - 2 && !open; y++) {
+            for (int x = 2; x < ref->width - 2 && !open; x++) open = !covered[y * ref->width + x];
+        }
+        if (!open) {
+            ref->won = true;
+            ref->gameOver = true;
+            return true;
+        }
+        ref->foodX = engine.foodX;
+        ref->foodY = engine.foodY;
+        if (!IsReferenceFoodCell(*ref, ref->foodX, ref->foodY) || covered[ref->foodY * ref->width + ref->foodX]) {
+            return false;
+        }
+
+        if (ref->speed > 50) ref->speed -= 5;
+    }
+    return true;
+}
+
+// Compare the engine with the reference: the same flags, score, speed and food,
+// the same body (the reference repeats its tail while the engine owes growth),
+// and a bitboard and free list that hold exactly the cells that body leaves
+static bool MatchesReference(const GameState& game, const ReferenceGame& ref, const char** what) {
+    *what = nullptr;
+    if (game.gameOver != ref.gameOver || game.won != ref.won) *what = "game over";
+    else if (game.score != ref.score || game.speed != ref.speed) *what = "score";
+    else if (game.dir != ref.dir) *what = "direction";
+    else if (game.foodX != ref.foodX || game.foodY != ref.foodY) *what = "food";
+    else if (game.snake.size() + game.growth != ref.snake.size()) *what = "length";
+    if (*what != nullptr) return false;
+    for (size_t i = 0; i < ref.snake.size(); i++) {
+        const SnakeSegment& segment = game.snake[min(i, game.snake.size() - 1)];
+        if (segment.x != ref.snake[i].x || segment.y != ref.snake[i].y) {
+            *what = "body";
+            return false;
+        }
+    }
+
+    // The engine does not take in the cell a fatal head moved onto
+    if (game.gameOver) return true;
+    vector<char> covered;
+    ReferenceCovered(ref, &covered);
+    size_t freeCount = 0;
+    for (int y = 0; y < ref.height; y++) {
+        for (int x = 0; x < ref.width; x++) {
+            int cell = y * ref.width + x;
+            if (IsOccupied(game, x, y) != (covered[cell] != 0)) *what = "occupancy";
+            bool isFree = IsReferenceFoodCell(ref, x, y) && !covered[cell];
+            int slot = game.freeSlot[cell];
+            if (isFree) freeCount++;
+            if (isFree != (slot >= 0) || (slot >= 0 && (slot >= static_cast<int>(game.freeCells.size()) || game.freeCells[slot] != cell))) {
+                *what = "free list";
+            }
+        }
+    }
+    if (*what == nullptr && freeCount != game.freeCells.size()) *what = "free list";
+    return *what == nullptr;
+}
+
+// Play seeded games on the engine and the reference side by side, comparing
+// them after every tick. Most games follow the recording bot, which also runs
+// into itself; some small boards are played to a win by the Hamiltonian
+// autopilot. Boards include the compiled kernel sizes and the runtime path.
+int VerifyEngine(int games, uint64_t seed) {
+    struct Board {
+        int width;
+        int height;
+        bool specialized;
+        bool autopilot;
+    };
+    const Board boards[] = {
+        { WIDTH, HEIGHT, true, false },
+        { HEIGHT, HEIGHT, true, false },
+        { WIDTH, HEIGHT, false, false },
+        { 13, 9, false, false },
+        { 8, 8, false, true },
+        { 10, 10, false, true },
+    };
+    const uint32_t maxTicks = 20000;
+
+    Rng rng(seed);
+    rng.Jump();
+    GameState game;
+    game.currentUser = nullptr;
+    ReferenceGame ref;
+    Autopilot* pilot = new Autopilot;
+    int failed = 0;
+    int wins = 0;
+    long long ticks = 0;
+    for (int i = 0; i < games; i++) {
+        const Board& board = boards[i % (sizeof(boards) / sizeof(boards[0]))];
+        GameConfig config;
+        config.width = board.width;
+        config.height = board.height;
+        config.seed = seed + i;
+        config.specialized = board.specialized;
+        Setup(&game, config);
+        ReferenceSetup(&ref, game);
+        if (board.autopilot) InitAutopilot(pilot, game, HAMILTONIAN, 1000000);
+
+        const char* what = nullptr;
+        bool legal = MatchesReference(game, ref, &what);
+        while (legal && what == nullptr && !game.gameOver && game.tick < maxTicks) {
+            Direction dir = board.autopilot ? ChooseMove(pilot, game) : BotMove(game, &rng);
+            Simulate(&game, &dir, 1);
+            ReferenceTurn(&ref, dir);
+            legal = ReferenceLogic(&ref, game);
+            if (legal) MatchesReference(game, ref, &what);
+        }
+        ticks += game.tick;
+        if (game.won) wins++;
+        if (!legal || what != nullptr) {
+            printf("game %d (%dx%d seed %llu): MISMATCH at tick %u: %s\n", i, board.width, board.height,
+                static_cast<unsigned long long>(config.seed), game.tick, legal ? what : "food on an illegal cell");
+            failed++;
+        }
+    }
+    delete pilot;
+    printf("games=%d failed=%d wins=%d ticks=%lld\n", games, failed, wins, ticks);
+    return failed == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    string command = argc > 1 ? argv[1] : "";
+    if (command == "record" && argc > 3) {
+        return RecordGames(atoi(argv[2]), argv[3],
+            argc > 4 ? static_cast<unsigned int>(strtoul(argv[4], nullptr, 10)) : 1,
+            argc > 5 ? atoi(argv[5]) : WIDTH, argc > 6 ? atoi(argv[6]) : HEIGHT);
+    }
+    if (command == "check" && argc > 2) {
+        return CheckReplays(argc - 2, argv + 2);
+    }
+    if (command == "play" && argc > 2) {
+        return PlayRendered(argv[2], argc > 3 ? atoi(argv[3]) : 100);
+    }
+    if (command == "seek" && argc > 2) {
+        return SeekReplayCheck(argv[2], argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : VIEWER_KEYFRAME_INTERVAL,
+            argc > 4 ? static_cast<size_t>(atoi(argv[4])) : VIEWER_KEYFRAMES);
+    }
+    AutopilotStrategy strategy;
+    if (command == "auto" && argc > 3 && ParseStrategy(argv[2], &strategy)) {
+        return RunAutopilot(strategy, atoi(argv[3]), argc > 4 ? atoi(argv[4]) : 1000,
+            argc > 5 ? atoi(argv[5]) : WIDTH, argc > 6 ? atoi(argv[6]) : HEIGHT);
+    }
+    if (command == "arena" && argc > 3) {
+        return RunArena(atoi(argv[2]), atoi(argv[3]), argc > 4 ? atoi(argv[4]) : 40, argc > 5 ? atoi(argv[5]) : 20,
+            argc > 6 ? atoi(argv[6]) : 8, argc > 7 ? atoi(argv[7]) : 0);
+    }
+    if (command == "batch" && argc > 4 && ParseStrategy(argv[2], &strategy)) {
+        BatchConfig config;
+        config.strategy = strategy;
+        config.games = atoi(argv[3]);
+        config.threads = argc > 5 ? atoi(argv[5]) : 0;
+        config.game.seed = argc > 6 ? strtoull(argv[6], nullptr, 10) : 1;
+        config.budgetUs = argc > 7 ? atoi(argv[7]) : 1000;
+        config.game.width = argc > 8 ? atoi(argv[8]) : WIDTH;
+        config.game.height = argc > 9 ? atoi(argv[9]) : HEIGHT;
+        config.tickLimit = 0;
+        return RunBatchGames(config, argv[4]);
+    }
+    if (command == "verify" && argc > 2) {
+        return VerifyEngine(atoi(argv[2]), argc > 3 ? strtoull(argv[3], nullptr, 10) : 1);
+    }
+
+    fprintf(stderr,
+        "usage: SnakeSim record <count> <prefix> [seed] [width] [height]\n"
+        "       SnakeSim check <replay>...\n"
+        "       SnakeSim play <replay> [msPerTick]\n"
+        "       SnakeSim seek <replay> [interval] [keyframes]\n"
+        "       SnakeSim auto <bfs|astar|hamiltonian> <games> [budgetUs] [width] [height]\n"
+        "       SnakeSim arena <snakes> <ticks> [width] [height] [food] [msPerTick]\n"
+        "       SnakeSim batch <bfs|astar|hamiltonian> <games> <results.csv> [threads] [seed] [budgetUs] [width] [height]\n"
+        "       SnakeSim verify <games> [seed]\n");
+    return 2;
+}
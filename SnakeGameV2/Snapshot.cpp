@@ -0,0 +1,337 @@
+#include "Snapshot.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "FileSync.h"
+#include "Varint.h"
+
+using namespace std;
+
+const char SNAPSHOT_MAGIC[4] = { 'S', 'N', 'K', 'S' };
+const uint8_t SNAPSHOT_VERSION = 1;
+const char SAVE_MAGIC[4] = { 'S', 'N', 'K', 'G' };
+const uint8_t SAVE_VERSION = 1;
+
+// Random source state words are spread evenly over all 64 bits, so they are
+// stored as they are rather than as varints
+static void PutWord(vector<uint8_t>* out, uint64_t value) {
+    for (int i = 0; i < 8; i++) out->push_back(static_cast<uint8_t>(value >> (i * 8)));
+}
+
+static bool GetWord(const uint8_t** data, const uint8_t* end, uint64_t* value) {
+    if (end - *data < 8) return false;
+    *value = 0;
+    for (int i = 0; i < 8; i++) *value |= uint64_t(*(*data)++) << (i * 8);
+    return true;
+}
+
+// Food spawns at least two cells away from the walls
+static bool IsSnapshotFoodCell(const GameState& game, int x, int y) {
+    return x >= 2 && x < game.width - 2 && y >= 2 && y < game.height - 2;
+}
+
+// Two-bit code for the step from one segment to the next one towards the tail
+static uint8_t StepCode(const SnakeSegment& from, const SnakeSegment& to) {
+    if (to.x < from.x) return 0;
+    if (to.x > from.x) return 1;
+    return (to.y < from.y) ? 2 : 3;
+}
+
+void EncodeSnapshot(const GameState& game, vector<uint8_t>* out) {
+    out->assign(SNAPSHOT_MAGIC, SNAPSHOT_MAGIC + sizeof(SNAPSHOT_MAGIC));
+    out->push_back(SNAPSHOT_VERSION);
+    PutVarint(out, game.width);
+    PutVarint(out, game.height);
+    PutVarint(out, game.tick);
+    PutVarint(out, static_cast<uint64_t>(game.score));
+    PutVarint(out, static_cast<uint64_t>(game.speed));
+    PutVarint(out, static_cast<uint64_t>(game.growth));
+    PutVarint(out, static_cast<uint64_t>(game.foodX));
+    PutVarint(out, static_cast<uint64_t>(game.foodY));
+    PutVarint(out, (game.gameOver ? 1 : 0) | (game.won ? 2 : 0));
+    PutVarint(out, game.dir);
+    PutVarint(out, static_cast<uint64_t>(game.pendingCount));
+    for (int i = 0; i < game.pendingCount; i++) PutVarint(out, game.pendingTurns[i]);
+
+    uint64_t rngState[4];
+    game.rng.GetState(rngState);
+    for (uint64_t word : rngState) PutWord(out, word);
+
+    // The head, then the step to each following segment, four steps to a byte
+    size_t length = game.snake.size();
+    PutVarint(out, length);
+    PutVarint(out, static_cast<uint64_t>(game.snake[0].x));
+    PutVarint(out, static_cast<uint64_t>(game.snake[0].y));
+    uint8_t packed = 0;
+    for (size_t i = 1; i < length; i++) {
+        packed |= StepCode(game.snake[i - 1], game.snake[i]) << (((i - 1) & 3) * 2);
+        if (((i - 1) & 3) == 3 || i == length - 1) {
+            out->push_back(packed);
+            packed = 0;
+        }
+    }
+
+    // The free-cell list is most of the snapshot, so its varints are written
+    // into room made for the longest ones rather than a byte at a time
+    PutVarint(out, game.freeCells.size());
+    size_t at = out->size();
+    out->resize(at + game.freeCells.size() * 5);
+    uint8_t* next = out->data() + at;
+    for (int cell : game.freeCells) {
+        uint32_t value = static_cast<uint32_t>(cell);
+        while (value >= 0x80) {
+            *next++ = static_cast<uint8_t>(value | 0x80);
+            value >>= 7;
+        }
+        *next++ = static_cast<uint8_t>(value);
+    }
+    out->resize(static_cast<size_t>(next - out->data()));
+}
+
+bool DecodeSnapshot(const uint8_t* data, size_t size, GameState* game) {
+    const uint8_t* end = data + size;
+    if (size < sizeof(SNAPSHOT_MAGIC) + 1 || memcmp(data, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+        data[sizeof(SNAPSHOT_MAGIC)] != SNAPSHOT_VERSION) {
+        return false;
+    }
+    data += sizeof(SNAPSHOT_MAGIC) + 1;
+
+    uint64_t width, height, tick, score, speed, growth, foodX, foodY, flags, dir, pendingCount;
+    if (!GetVarint(&data, end, &width) || !GetVarint(&data, end, &height) ||
+        !GetVarint(&data, end, &tick) || !GetVarint(&data, end, &score) ||
+        !GetVarint(&data, end, &speed) || !GetVarint(&data, end, &growth) ||
+        !GetVarint(&data, end, &foodX) || !GetVarint(&data, end, &foodY) ||
+        !GetVarint(&data, end, &flags) || !GetVarint(&data, end, &dir) ||
+        !GetVarint(&data, end, &pendingCount)) {
+        return false;
+    }
+    if (width < MIN_BOARD_SIZE || width > MAX_BOARD_SIZE || height < MIN_BOARD_SIZE || height > MAX_BOARD_SIZE ||
+        foodX >= width || foodY >= height || dir > DOWN || pendingCount > TURN_BUFFER_SIZE ||
+        speed < MIN_SPEED || speed > START_SPEED || growth > static_cast<uint64_t>(width) * height) {
+        return false;
+    }
+    Direction pendingTurns[TURN_BUFFER_SIZE];
+    for (uint64_t i = 0; i < pendingCount; i++) {
+        uint64_t turn;
+        if (!GetVarint(&data, end, &turn) || turn < LEFT || turn > DOWN) return false;
+        pendingTurns[i] = static_cast<Direction>(turn);
+    }
+    uint64_t rngState[4];
+    for (uint64_t& word : rngState) {
+        if (!GetWord(&data, end, &word)) return false;
+    }
+
+    size_t cells = static_cast<size_t>(width) * height;
+    uint64_t length, headX, headY;
+    if (!GetVarint(&data, end, &length) || !GetVarint(&data, end, &headX) || !GetVarint(&data, end, &headY) ||
+        length < 1 || length > cells || headX >= width || headY >= height ||
+        static_cast<size_t>(end - data) < (length - 1 + 3) / 4) {
+        return false;
+    }
+
+    game->width = static_cast<int>(width);
+    game->height = static_cast<int>(height);
+    game->kernel = FindBoardKernel(game->width, game->height);
+    game->tick = static_cast<uint32_t>(tick);
+    game->score = static_cast<int>(score);
+    game->speed = static_cast<int>(speed);
+    game->growth = static_cast<int>(growth);
+    game->foodX = static_cast<int>(foodX);
+    game->foodY = static_cast<int>(foodY);
+    game->gameOver = (flags & 1) != 0;
+    game->won = (flags & 2) != 0;
+    game->dir = static_cast<Direction>(dir);
+    game->pendingCount = static_cast<int>(pendingCount);
+    for (uint64_t i = 0; i < pendingCount; i++) game->pendingTurns[i] = pendingTurns[i];
+    game->rng.SetState(rngState);
+
+    // Rebuild the body and its occupancy. Segments follow each other by
+    // construction, and none may share a cell or sit on a wall, except the head
+    // of a game that ended by running into one. That head was never marked.
+    game->snake.Reset(cells);
+    game->occupied.assign((cells + 63) / 64, 0);
+    SnakeSegment segment;
+    segment.x = static_cast<int>(headX);
+    segment.y = static_cast<int>(headY);
+    int headCell = segment.y * game->width + segment.x;
+    size_t coveredFoodCells = 0;
+    for (uint64_t i = 0; i < length; i++) {
+        if (i > 0) {
+            int step = (data[(i - 1) / 4] >> (((i - 1) & 3) * 2)) & 3;
+            if (step == 0) segment.x--;
+            else if (step == 1) segment.x++;
+            else if (step == 2) segment.y--;
+            else segment.y++;
+            if (segment.x < 0 || segment.y < 0 || segment.x >= game->width || segment.y >= game->height) return false;
+        }
+        game->snake.PushBack(segment);
+        int cell = segment.y * game->width + segment.x;
+        bool inside = segment.x > 0 && segment.y > 0 && segment.x < game->width - 1 && segment.y < game->height - 1;
+        if (!inside) {
+            if (i > 0 || !game->gameOver) return false;
+            continue;
+        }
+        if (IsOccupied(*game, segment.x, segment.y)) {
+            if (cell != headCell || !game->gameOver) return false;
+            continue;
+        }
+        game->occupied[cell >> 6] |= uint64_t(1) << (cell & 63);
+        if (IsSnapshotFoodCell(*game, segment.x, segment.y)) coveredFoodCells++;
+    }
+    data += (length - 1 + 3) / 4;
+
+    // The free-cell list in its saved order, with its index rebuilt. It must
+    // hold exactly the food cells the body leaves, the food among them while
+    // the game runs.
+    uint64_t freeCount;
+    size_t foodCells = static_cast<size_t>(width - 4) * (height - 4);
+    if (!GetVarint(&data, end, &freeCount) || freeCount != foodCells - coveredFoodCells) return false;
+    game->freeSlot.assign(cells, -1);
+    game->freeCells.reserve(cells);
+    game->freeCells.resize(static_cast<size_t>(freeCount));
+    for (uint64_t i = 0; i < freeCount; i++) {
+        uint64_t cell;
+        if (!GetVarint(&data, end, &cell) || cell >= cells || game->freeSlot[cell] != -1) return false;
+        int x = static_cast<int>(cell % width);
+        int y = static_cast<int>(cell / width);
+        if (!IsSnapshotFoodCell(*game, x, y) || IsOccupied(*game, x, y)) return false;
+        game->freeSlot[cell] = static_cast<int>(i);
+        game->freeCells[i] = static_cast<int>(cell);
+    }
+    if (!game->gameOver && game->freeSlot[game->foodY * game->width + game->foodX] < 0) return false;
+    return data == end;
+}
+
+void InitKeyframes(KeyframeRing* ring, uint32_t interval, size_t capacity) {
+    ring->interval = max<uint32_t>(interval, 1);
+    ring->frames.resize(max<size_t>(capacity, 1)); // buffers already in the ring are kept for reuse
+    ring->ticks.assign(ring->frames.size(), 0);
+    ring->first = 0;
+    ring->count = 0;
+}
+
+void TakeKeyframe(KeyframeRing* ring, const GameState& game) {
+    size_t capacity = ring->frames.size();
+    if (game.tick % ring->interval != 0) return;
+    if (ring->count > 0 && ring->ticks[(ring->first + ring->count - 1) % capacity] >= game.tick) return;
+
+    size_t slot;
+    if (ring->count < capacity) {
+        slot = (ring->first + ring->count) % capacity;
+        ring->count++;
+    }
+    else {
+        slot = ring->first;
+        ring->first = (ring->first + 1) % capacity;
+    }
+    EncodeSnapshot(game, &ring->frames[slot]);
+    ring->ticks[slot] = game.tick;
+}
+
+bool RestoreKeyframe(const KeyframeRing& ring, uint32_t tick, GameState* game) {
+    size_t capacity = ring.frames.size();
+    for (size_t i = ring.count; i-- > 0;) {
+        size_t slot = (ring.first + i) % capacity;
+        if (ring.ticks[slot] <= tick) {
+            const vector<uint8_t>& frame = ring.frames[slot];
+            return DecodeSnapshot(frame.data(), frame.size(), game);
+        }
+    }
+    return false;
+}
+
+bool SeekReplay(const Replay& replay, const KeyframeRing& ring, uint32_t tick, GameState* game, ReplayCursor* cursor) {
+    if (RestoreKeyframe(ring, tick, game)) {
+        // Keyframes are taken between ticks, before the next tick's turns are queued
+        auto next = lower_bound(replay.events.begin(), replay.events.end(), game->tick,
+            [](const ReplayEvent& event, uint32_t t) { return event.tick < t; });
+        cursor->nextEvent = static_cast<size_t>(next - replay.events.begin());
+    }
+    else {
+        StartPlayback(replay, game, cursor);
+    }
+
+    while (game->tick < tick) {
+        if (!StepPlayback(replay, game, cursor)) return false;
+    }
+    return true;
+}
+
+bool SaveGame(const string& path, const string& owner, const GameState& game, const Replay& replay) {
+    vector<uint8_t> bytes(SAVE_MAGIC, SAVE_MAGIC + sizeof(SAVE_MAGIC));
+    bytes.push_back(SAVE_VERSION);
+    PutVarint(&bytes, owner.size());
+    bytes.insert(bytes.end(), owner.begin(), owner.end());
+
+    // The snapshot, length first, then the replay up to the snapshot's tick
+    vector<uint8_t> part;
+    EncodeSnapshot(game, &part);
+    PutVarint(&bytes, part.size());
+    bytes.insert(bytes.end(), part.begin(), part.end());
+    Replay recorded = replay;
+    FinishRecording(&recorded, game);
+    EncodeReplay(recorded, &part);
+    bytes.insert(bytes.end(), part.begin(), part.end());
+
+    // A crash while saving must not cost the save already there
+    return WriteFileAtomically(path, bytes.data(), bytes.size());
+}
+
+bool LoadGame(const string& path, const string& owner, GameState* game, Replay* replay) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+
+    vector<uint8_t> bytes;
+    uint8_t buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        bytes.insert(bytes.end(), buffer, buffer + n);
+    }
+    fclose(file);
+
+    const uint8_t* data = bytes.data();
+    const uint8_t* end = data + bytes.size();
+    if (bytes.size() < sizeof(SAVE_MAGIC) + 1 || memcmp(data, SAVE_MAGIC, sizeof(SAVE_MAGIC)) != 0 ||
+        data[sizeof(SAVE_MAGIC)] != SAVE_VERSION) {
+        return false;
+    }
+    data += sizeof(SAVE_MAGIC) + 1;
+
+    uint64_t ownerLength, snapshotLength;
+    if (!GetVarint(&data, end, &ownerLength) || ownerLength > static_cast<uint64_t>(end - data)) return false;
+    if (ownerLength != owner.size() || memcmp(data, owner.data(), owner.size()) != 0) return false;
+    data += ownerLength;
+    if (!GetVarint(&data, end, &snapshotLength) || snapshotLength > static_cast<uint64_t>(end - data) ||
+        !DecodeSnapshot(data, static_cast<size_t>(snapshotLength), game)) {
+        return false;
+    }
+    data += snapshotLength;
+
+    // Recording picks up where the saved replay ends
+    if (!DecodeReplay(data, static_cast<size_t>(end - data), replay) || replay->ticks != game->tick) {
+        return false;
+    }
+    replay->events.reserve(REPLAY_RESERVED_EVENTS);
+    return true;
+}
+
+string SaveGamePath(const string& owner) {
+    if (owner.empty()) return "save-guest.snk";
+    string path = "save-";
+    for (size_t i = 0; i < owner.size(); i++) {
+        unsigned char ch = static_cast<unsigned char>(owner[i]);
+        bool plain = (ch >= 'a' && ch <= 'z') || (ch >= '0' && ch <= '9') || ch == '-' || ch == '_';
+        // A user called "guest" has its first letter escaped, keeping clear of the guests' file
+        if (i == 0 && owner == "guest") plain = false;
+        if (plain) {
+            path += static_cast<char>(ch);
+        }
+        else {
+            char escaped[4];
+            snprintf(escaped, sizeof(escaped), "%%%02X", ch);
+            path += escaped;
+        }
+    }
+    return path + ".snk";
+}
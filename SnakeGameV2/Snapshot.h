@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Engine.h"
+#include "Replay.h"
+
+// Compact binary form of a GameState: the board size, tick, score, speed, food,
+// direction and queued turns, the random source's state, the snake as its head
+// followed by two bits per segment, and the free-cell list in its current order
+// (food placement picks from it by index, so the order decides every later food
+// position). The occupancy bitboard and free-cell index are rebuilt on restore.
+// A 30x20 game takes about a kilobyte, most of it the free-cell list.
+void EncodeSnapshot(const GameState& game, std::vector<uint8_t>* out);
+
+// Restore a game from EncodeSnapshot() output. The game continues exactly as the
+// one it was taken from would have; currentUser is left as it was. Reuses the
+// game's buffers, so restoring a board of the same size does not allocate.
+// Snapshots that could not come from a real game are rejected: fields out of
+// range, overlapping segments, or a free list that is not exactly the food
+// cells the body leaves.
+bool DecodeSnapshot(const uint8_t* data, size_t size, GameState* game);
+
+// Snapshots taken every interval ticks into a fixed number of slots; once every
+// slot is used, each new keyframe replaces the oldest. Slot buffers are reused,
+// so taking keyframes does not allocate once the ring has gone round.
+struct KeyframeRing {
+    uint32_t interval;
+    std::vector<std::vector<uint8_t>> frames; // encoded snapshots
+    std::vector<uint32_t> ticks; // tick of the snapshot in each slot
+    size_t first; // slot of the oldest keyframe
+    size_t count;
+};
+
+void InitKeyframes(KeyframeRing* ring, uint32_t interval, size_t capacity);
+
+// Take a keyframe if the game is on a multiple of the interval newer than the
+// newest keyframe; call it after every tick
+void TakeKeyframe(KeyframeRing* ring, const GameState& game);
+
+// Restore the newest keyframe at or before tick; false if the ring has none
+bool RestoreKeyframe(const KeyframeRing& ring, uint32_t tick, GameState* game);
+
+// Put a replay's playback at tick: restore the nearest earlier keyframe and run
+// the recorded turns from there, at most interval ticks. Ticks older than the
+// oldest keyframe are replayed from the start. Returns false if tick is past the
+// end of the replay, leaving the game at its last tick.
+bool SeekReplay(const Replay& replay, const KeyframeRing& ring, uint32_t tick, GameState* game, ReplayCursor* cursor);
+
+// A game put aside to finish later: its owner (a username, or empty for a
+// guest), a snapshot to resume from, and the replay recorded so far, which
+// recording continues into once the game is resumed. The file is replaced
+// atomically, so a crash mid-save leaves the previous save intact.
+bool SaveGame(const std::string& path, const std::string& owner, const GameState& game, const Replay& replay);
+
+// Load the game saved at path if it belongs to owner. The owner is checked
+// before anything is decoded, so another player's save leaves game and replay
+// untouched; a damaged one may leave them part-way, to be set up afresh.
+bool LoadGame(const std::string& path, const std::string& owner, GameState* game, Replay* replay);
+
+// Each player's save file: save-<username>.snk, or save-guest.snk for guests.
+// Characters other than lowercase letters, digits, '-' and '_' are written as
+// %XX, so names differing only in case or holding path separators get files of
+// their own, and no username maps onto the guests' file.
+std::string SaveGamePath(const std::string& owner);
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Lock-free bounded queue for exactly one producer thread and one consumer thread.
+// Capacity must be a power of two; one slot is kept empty to tell full from empty.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+    // Producer side; returns false if the queue is full
+    bool Push(const T& item) {
+        size_t tail = writePos.load(std::memory_order_relaxed);
+        size_t next = (tail + 1) & (Capacity - 1);
+        if (next == readPos.load(std::memory_order_acquire)) return false;
+        items[tail] = item;
+        writePos.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; returns false if the queue is empty
+    bool Pop(T* item) {
+        size_t head = readPos.load(std::memory_order_relaxed);
+        if (head == writePos.load(std::memory_order_acquire)) return false;
+        *item = items[head];
+        readPos.store((head + 1) & (Capacity - 1), std::memory_order_release);
+        return true;
+    }
+
+private:
+    // Producer and consumer indices live on separate cache lines
+    alignas(64) std::atomic<size_t> writePos{ 0 };
+    alignas(64) std::atomic<size_t> readPos{ 0 };
+    T items[Capacity];
+};
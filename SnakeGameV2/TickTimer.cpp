@@ -0,0 +1,69 @@
+#include "TickTimer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+
+// Sleeps can overshoot by a scheduler quantum, so the last stretch is spent yielding
+const microseconds SPIN_MARGIN(2000);
+
+void StartTimer(TickTimer* timer, int periodMs, int maxCatchUp) {
+    timer->period = milliseconds(periodMs);
+    timer->nextTick = steady_clock::now() + timer->period;
+    timer->maxCatchUp = maxCatchUp;
+    timer->ticks = 0;
+    timer->droppedTicks = 0;
+    timer->jitterSamples = 0;
+    timer->jitterSumUs = 0;
+    timer->jitterSqSumUs = 0;
+    timer->jitterMaxUs = 0;
+}
+
+void SetTimerPeriod(TickTimer* timer, int periodMs) {
+    microseconds period = milliseconds(periodMs);
+    timer->nextTick += period - timer->period;
+    timer->period = period;
+}
+
+void WaitForTick(const TickTimer* timer) {
+    if (steady_clock::now() < timer->nextTick - SPIN_MARGIN) {
+        this_thread::sleep_until(timer->nextTick - SPIN_MARGIN);
+    }
+    while (steady_clock::now() < timer->nextTick) {
+        this_thread::yield();
+    }
+}
+
+int DueTicks(TickTimer* timer) {
+    steady_clock::time_point now = steady_clock::now();
+    if (now < timer->nextTick) return 0;
+
+    double lateUs = duration<double, micro>(now - timer->nextTick).count();
+    timer->jitterSamples++;
+    timer->jitterSumUs += lateUs;
+    timer->jitterSqSumUs += lateUs * lateUs;
+    if (lateUs > timer->jitterMaxUs) timer->jitterMaxUs = lateUs;
+
+    long long due = (now - timer->nextTick) / timer->period + 1;
+    if (due > timer->maxCatchUp) {
+        timer->droppedTicks += due - timer->maxCatchUp;
+        due = timer->maxCatchUp;
+    }
+    // Deadlines stay on the original grid even when ticks are dropped
+    timer->nextTick += timer->period * ((now - timer->nextTick) / timer->period + 1);
+    timer->ticks += due;
+    return static_cast<int>(due);
+}
+
+double MeanJitterUs(const TickTimer& timer) {
+    return timer.jitterSamples > 0 ? timer.jitterSumUs / timer.jitterSamples : 0.0;
+}
+
+double JitterStdDevUs(const TickTimer& timer) {
+    if (timer.jitterSamples == 0) return 0.0;
+    double mean = MeanJitterUs(timer);
+    return sqrt(max(0.0, timer.jitterSqSumUs / timer.jitterSamples - mean * mean));
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+
+// Fixed-timestep scheduler on the monotonic clock. Tick deadlines are exact
+// multiples of the period from the start time, so time spent drawing or reading
+// input does not stretch the tick period and the game speed does not drift.
+struct TickTimer {
+    std::chrono::steady_clock::time_point nextTick; // deadline of the next tick
+    std::chrono::microseconds period;
+    int maxCatchUp; // ticks run back to back before falling behind is given up on
+
+    long long ticks;
+    long long droppedTicks;
+
+    // Lateness of each wake-up against the deadline it was waiting for
+    long long jitterSamples;
+    double jitterSumUs;
+    double jitterSqSumUs;
+    double jitterMaxUs;
+};
+
+// Start ticking now with the given period
+void StartTimer(TickTimer* timer, int periodMs, int maxCatchUp = 5);
+
+// Change the period from the next deadline on
+void SetTimerPeriod(TickTimer* timer, int periodMs);
+
+// Sleep until the next tick is due
+void WaitForTick(const TickTimer* timer);
+
+// Number of ticks whose deadline has passed. Up to maxCatchUp late ticks are
+// returned for the caller to run back to back; beyond that the schedule skips
+// ahead and the skipped ticks are counted as dropped.
+int DueTicks(TickTimer* timer);
+
+// Jitter statistics in microseconds
+double MeanJitterUs(const TickTimer& timer);
+double JitterStdDevUs(const TickTimer& timer);
@@ -0,0 +1,69 @@
+#include "UserDirectory.h"
+
+#include <algorithm>
+
+using namespace std;
+
+uint32_t HashUsername(const string& username) {
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : username) {
+        hash ^= c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void UserDirectory::Clear() {
+    users.clear();
+    slots.assign(16, Slot{ 0, 0 });
+}
+
+void UserDirectory::Reserve(size_t count) {
+    size_t slotCount = 16;
+    while (slotCount < count * 2) slotCount *= 2;
+    if (slotCount > slots.size()) Rehash(slotCount);
+}
+
+// Linear probe for the username: returns its slot, or the empty slot where it would go
+size_t UserDirectory::FindSlot(const string& username, uint32_t hash) const {
+    size_t mask = slots.size() - 1;
+    size_t i = hash & mask;
+    while (slots[i].index != 0) {
+        if (slots[i].hash == hash && users[slots[i].index - 1].username == username) break;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+void UserDirectory::Rehash(size_t slotCount) {
+    vector<Slot> old;
+    old.swap(slots);
+    slots.assign(slotCount, Slot{ 0, 0 });
+
+    size_t mask = slotCount - 1;
+    for (const Slot& slot : old) {
+        if (slot.index == 0) continue;
+        size_t i = slot.hash & mask;
+        while (slots[i].index != 0) i = (i + 1) & mask;
+        slots[i] = slot;
+    }
+}
+
+User* UserDirectory::Find(const string& username) {
+    if (slots.empty()) return nullptr;
+    size_t i = FindSlot(username, HashUsername(username));
+    return slots[i].index != 0 ? &users[slots[i].index - 1] : nullptr;
+}
+
+User* UserDirectory::Add(const User& user) {
+    if ((users.size() + 1) * 2 > slots.size()) Rehash(max<size_t>(16, slots.size() * 2));
+
+    uint32_t hash = HashUsername(user.username);
+    size_t i = FindSlot(user.username, hash);
+    if (slots[i].index != 0) return nullptr;
+
+    users.push_back(user);
+    slots[i].hash = hash;
+    slots[i].index = static_cast<uint32_t>(users.size());
+    return &users.back();
+}
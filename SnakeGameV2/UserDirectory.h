@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+#include "UserStore.h"
+
+// In-memory user directory. Users live in a deque, so the User* handles it hands
+// out stay valid while more users are added; an open-addressing hash table keyed
+// by the username finds them in O(1) on average.
+class UserDirectory {
+public:
+    void Clear();
+    void Reserve(size_t count);
+
+    // The user with this name, or nullptr
+    User* Find(const std::string& username);
+
+    // Add a user; returns its handle, or nullptr if the name is already taken
+    User* Add(const User& user);
+
+    size_t size() const { return users.size(); }
+
+    // All users in the order they were added
+    const std::deque<User>& All() const { return users; }
+
+private:
+    struct Slot {
+        uint32_t hash;
+        uint32_t index; // position in users plus one; 0 marks an empty slot
+    };
+
+    size_t FindSlot(const std::string& username, uint32_t hash) const;
+    void Rehash(size_t slotCount);
+
+    std::deque<User> users;
+    std::vector<Slot> slots; // power-of-two size, at most half full
+};
+
+// 32-bit FNV-1a hash of a username
+uint32_t HashUsername(const std::string& username);
@@ -0,0 +1,164 @@
+#include "UserStore.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include "FileSync.h"
+
+using namespace std;
+
+const char STORE_MAGIC[4] = { 'S', 'N', 'K', 'U' };
+const uint32_t STORE_VERSION = 1;
+
+// On-disk layout, encoded byte by byte so the file reads the same on any host;
+// integers are little-endian.
+//   header: magic[4], version u32, recordSize u32, count u32
+//   record: username[64], password[64], highScore i32, reserved u32
+// Names are NUL-padded, and a record's last byte of each is always NUL.
+const size_t HEADER_SIZE = 16;
+const size_t NAME_FIELD_SIZE = MAX_CREDENTIAL_LENGTH + 1;
+const size_t HIGH_SCORE_OFFSET = 2 * NAME_FIELD_SIZE;
+const size_t RECORD_SIZE = HIGH_SCORE_OFFSET + 8;
+static_assert(HEADER_SIZE % 4 == 0 && RECORD_SIZE % 4 == 0, "high scores must stay 4-byte aligned");
+
+static void PutLe32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+static uint32_t GetLe32(const uint8_t* in) {
+    return uint32_t(in[0]) | uint32_t(in[1]) << 8 | uint32_t(in[2]) << 16 | uint32_t(in[3]) << 24;
+}
+
+static long RecordOffset(uint32_t slot) {
+    return static_cast<long>(HEADER_SIZE + static_cast<size_t>(slot) * RECORD_SIZE);
+}
+
+static void EncodeRecord(const User& user, uint8_t* record) {
+    memset(record, 0, RECORD_SIZE);
+    memcpy(record, user.username.data(), min(user.username.length(), MAX_CREDENTIAL_LENGTH));
+    memcpy(record + NAME_FIELD_SIZE, user.password.data(), min(user.password.length(), MAX_CREDENTIAL_LENGTH));
+    PutLe32(record + HIGH_SCORE_OFFSET, static_cast<uint32_t>(user.highScore));
+}
+
+static bool WriteHeader(FILE* file, uint32_t count) {
+    uint8_t header[HEADER_SIZE];
+    memcpy(header, STORE_MAGIC, sizeof(STORE_MAGIC));
+    PutLe32(header + 4, STORE_VERSION);
+    PutLe32(header + 8, static_cast<uint32_t>(RECORD_SIZE));
+    PutLe32(header + 12, count);
+    return fseek(file, 0, SEEK_SET) == 0 &&
+        fwrite(header, sizeof(header), 1, file) == 1 &&
+        SyncFile(file);
+}
+
+// Build a complete store from the old text format in a temporary file, then move it into place
+static bool ImportTextUsers(const string& path, const string& legacyTextPath) {
+    ifstream text(legacyTextPath);
+    string tempPath = path + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (!file) return false;
+
+    bool ok = WriteHeader(file, 0);
+    uint32_t count = 0;
+    User user;
+    while (ok && text.is_open() && text >> user.username >> user.password >> user.highScore) {
+        if (user.username.length() > MAX_CREDENTIAL_LENGTH || user.password.length() > MAX_CREDENTIAL_LENGTH) {
+            continue; // Cannot be stored without changing the user's login
+        }
+        uint8_t record[RECORD_SIZE];
+        EncodeRecord(user, record);
+        ok = fseek(file, RecordOffset(count), SEEK_SET) == 0 && fwrite(record, sizeof(record), 1, file) == 1;
+        count++;
+    }
+    ok = ok && WriteHeader(file, count);
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok || rename(tempPath.c_str(), path.c_str()) != 0) {
+        remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool OpenUserStore(UserStore* store, const string& path, const string& legacyTextPath) {
+    store->file = fopen(path.c_str(), "r+b");
+    if (!store->file) {
+        // Only a store that is not there yet is built. One that cannot be opened
+        // (no permission, a read-only disk) holds users the old text file lacks,
+        // so importing over it would lose them.
+        if (errno != ENOENT) return false;
+        if (!ImportTextUsers(path, legacyTextPath)) return false;
+        store->file = fopen(path.c_str(), "r+b");
+        if (!store->file) return false;
+    }
+
+    uint8_t header[HEADER_SIZE];
+    if (fread(header, sizeof(header), 1, store->file) != 1 ||
+        memcmp(header, STORE_MAGIC, sizeof(STORE_MAGIC)) != 0 ||
+        GetLe32(header + 4) != STORE_VERSION || GetLe32(header + 8) != RECORD_SIZE) {
+        fclose(store->file);
+        store->file = nullptr;
+        return false;
+    }
+    store->count = GetLe32(header + 12);
+    return true;
+}
+
+bool ReadUsers(UserStore* store, vector<User>* users) {
+    users->clear();
+    if (!store->file) return false;
+
+    vector<uint8_t> records(static_cast<size_t>(store->count) * RECORD_SIZE);
+    if (store->count > 0 &&
+        (fseek(store->file, RecordOffset(0), SEEK_SET) != 0 ||
+         fread(records.data(), RECORD_SIZE, store->count, store->file) != store->count)) {
+        return false;
+    }
+
+    users->reserve(store->count);
+    for (uint32_t i = 0; i < store->count; i++) {
+        uint8_t* record = &records[static_cast<size_t>(i) * RECORD_SIZE];
+        record[NAME_FIELD_SIZE - 1] = '\0';
+        record[2 * NAME_FIELD_SIZE - 1] = '\0';
+
+        User user;
+        user.username = reinterpret_cast<const char*>(record);
+        user.password = reinterpret_cast<const char*>(record + NAME_FIELD_SIZE);
+        user.highScore = static_cast<int32_t>(GetLe32(record + HIGH_SCORE_OFFSET));
+        user.record = i;
+        users->push_back(user);
+    }
+    return true;
+}
+
+bool AppendUser(UserStore* store, User* user) {
+    if (!store->file) return false;
+
+    // The record is invisible to readers until the header count covers it
+    uint8_t record[RECORD_SIZE];
+    EncodeRecord(*user, record);
+    if (fseek(store->file, RecordOffset(store->count), SEEK_SET) != 0 ||
+        fwrite(record, sizeof(record), 1, store->file) != 1 ||
+        !SyncFile(store->file) ||
+        !WriteHeader(store->file, store->count + 1)) {
+        return false;
+    }
+    user->record = store->count++;
+    return true;
+}
+
+bool SaveHighScore(UserStore* store, const User& user) {
+    if (!store->file || user.record >= store->count) return false;
+
+    uint8_t highScore[4];
+    PutLe32(highScore, static_cast<uint32_t>(user.highScore));
+    return fseek(store->file, RecordOffset(user.record) + static_cast<long>(HIGH_SCORE_OFFSET), SEEK_SET) == 0 &&
+        fwrite(highScore, sizeof(highScore), 1, store->file) == 1 &&
+        SyncFile(store->file);
+}
+
+void CloseUserStore(UserStore* store) {
+    if (store->file) fclose(store->file);
+    store->file = nullptr;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Longest username or password the store can hold
+const size_t MAX_CREDENTIAL_LENGTH = 63;
+
+// Record slot of a user that has not been written to the store yet
+const uint32_t NO_RECORD = 0xFFFFFFFF;
+
+// User structure for login system
+struct User {
+    std::string username;
+    std::string password;
+    int highScore;
+    uint32_t record; // Slot of this user's record in the store file
+};
+
+// Binary user store. The file is a small header followed by fixed-size records,
+// so a user's record is found by its slot number alone: registering appends one
+// record and a new high score rewrites one field in place, instead of rewriting
+// the whole file.
+//
+// Crash safety: a new record is written past the committed count and synced to
+// disk before the header's count is updated to take it in, and a score update
+// is a single aligned 4-byte write, synced before the call returns. Importing
+// writes and syncs a temporary file that is renamed into place only when complete.
+struct UserStore {
+    FILE* file;
+    uint32_t count; // committed records
+};
+
+// Open the store at path, creating it if needed. If it does not exist yet and
+// legacyTextPath names an old "username password highScore" text file, the
+// users in that file are imported once. A store that exists but cannot be
+// opened is left alone and the call fails.
+bool OpenUserStore(UserStore* store, const std::string& path, const std::string& legacyTextPath);
+
+// Read every user in the store with a single bulk read
+bool ReadUsers(UserStore* store, std::vector<User>* users);
+
+// Write a new user at the end of the store and set user->record
+bool AppendUser(UserStore* store, User* user);
+
+// Write a stored user's high score in place
+bool SaveHighScore(UserStore* store, const User& user);
+
+void CloseUserStore(UserStore* store);
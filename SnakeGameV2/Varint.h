@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// LEB128 varints: seven bits per byte, low bits first, high bit set on every
+// byte but the last. Small numbers, the common case, take a single byte.
+inline void PutVarint(std::vector<uint8_t>* out, uint64_t value) {
+    while (value >= 0x80) {
+        out->push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out->push_back(static_cast<uint8_t>(value));
+}
+
+// Read a varint and advance *data past it; returns false if it runs past end
+inline bool GetVarint(const uint8_t** data, const uint8_t* end, uint64_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 64 && *data < end; shift += 7) {
+        uint8_t byte = *(*data)++;
+        *value |= uint64_t(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}